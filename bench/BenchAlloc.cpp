@@ -0,0 +1,53 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. Heap allocations counter.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "BenchAlloc.h"
+/* External Includes */
+/* System Includes */
+#include <cstdlib>
+#include <new>
+
+
+static thread_local uint64_t gBenchAllocQty = 0;
+
+static void* benchAlloc(std::size_t size) {
+	gBenchAllocQty++;
+	void* p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+///////////////////// BenchAlloc /////////////////////
+uint64_t BenchAlloc::getQty() {
+	return gBenchAllocQty;
+}
+
+///////////////////// Global operators /////////////////////
+void* operator new(std::size_t size) {
+	return benchAlloc(size);
+}
+
+void* operator new[](std::size_t size) {
+	return benchAlloc(size);
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
@@ -0,0 +1,35 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. Heap allocations counter.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef BENCH_ALLOC_H_
+#define BENCH_ALLOC_H_
+
+/* Internal Includes */
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+
+
+/**
+ * Counts the heap allocations of the calling thread.
+ * The benchmark replaces the global operator new => allocations of the other
+ * threads (logger, command processors) are not mixed in.
+ */
+struct BenchAlloc {
+	/**
+	 * Number of allocations made by the calling thread since the start
+	 */
+	static uint64_t getQty();
+};
+
+#endif /* BENCH_ALLOC_H_ */
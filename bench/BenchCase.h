@@ -0,0 +1,126 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. Case context and the list of cases.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef BENCH_CASE_H_
+#define BENCH_CASE_H_
+
+/* Internal Includes */
+#include "Logger.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <string>
+#include <chrono>
+
+
+/**
+ * Sizes of the runs
+ */
+struct BenchConfig {
+	uint32_t										qty;		// operations per measurement
+	uint32_t										producers;	// threads feeding the command processors
+	uint32_t										wakeups;	// wake-up latency samples
+};
+
+/**
+ * Context of one benchmark case.
+ * Timings are only logged, they depend on the machine. Checks are exact
+ * properties (allocations, ordering, delivered frames) and fail the run.
+ */
+class BenchCase {
+public:
+	BenchCase(const std::string& name, const BenchConfig& config)
+	:
+		mLog(name),
+		mConfig(config),
+		mIsFailed(false)
+	{}
+
+	const Utils::Logger& log() const { return mLog; }
+	const BenchConfig& getConfig() const { return mConfig; }
+	bool isFailed() const { return mIsFailed; }
+
+	/**
+	 * Logs the check result; the failed check fails the case
+	 */
+	void check(bool condition, const std::string& what) {
+		if (condition) {
+			*mLog.info() << "PASS: " << what;
+		} else {
+			*mLog.error() << "FAIL: " << what;
+			mIsFailed = true;
+		}
+	}
+
+	/**
+	 * Average time of one operation in nanoseconds
+	 */
+	static double getNsPerOp(std::chrono::steady_clock::time_point start, uint64_t qty) {
+		const std::chrono::steady_clock::duration d = std::chrono::steady_clock::now() - start;
+		return qty ? static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) / qty : 0;
+	}
+private:
+	// Objects
+	Utils::Logger									mLog;
+	const BenchConfig								mConfig;
+	bool											mIsFailed;
+
+	// Do not copy
+	BenchCase(const BenchCase&);
+	BenchCase &operator=(const BenchCase&);
+};
+
+///////////////////// Cases /////////////////////
+/**
+ * Utils::CommandProcessor against the mutex queue: throughput, per-stream
+ * order, enqueue allocations and wake-up latency of the idle processor
+ */
+void benchProcessor(BenchCase&);
+
+/**
+ * Uplink frames: decoding in place, the reassembler path and the whole path
+ * to the route with the allocations of both threads
+ */
+void benchDecode(BenchCase&);
+
+/**
+ * Malformed uplink input: rejecting by status and the good frames
+ * throughput with the malformed input in between, API modes 2 and 1
+ */
+void benchResync(BenchCase&);
+
+/**
+ * Downlink ZB_TX_REQ encoding: the single pass encoder against the replaced
+ * insert based one, plain payload and payload of the bytes to escape
+ */
+void benchEncode(BenchCase&);
+
+/**
+ * Serial reads: pooled buffers against a new copy of every read and
+ * copying of the port name value
+ */
+void benchSerial(BenchCase&);
+
+/**
+ * Router hop: the unit queued as the command against the replaced command
+ * with the callback, switch by origin and cast
+ */
+void benchRoute(BenchCase&);
+
+/**
+ * Downlink flow control: a failed frame, a lost TX Status and the module
+ * reset must reset the device session; cost of the confirmed frame
+ */
+void benchTx(BenchCase&);
+
+#endif /* BENCH_CASE_H_ */
@@ -0,0 +1,466 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. XBee network frames.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "BenchCase.h"
+#include "BenchAlloc.h"
+#include "XBeeFrame.h"
+#include "XBeeFrameSchema.h"
+#include "XBeeNetFromBuffer.h"
+#include "CommandProcessor.h"
+#include "NetworkingDataUnit.h"
+#include "Configuration.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <iomanip>
+
+#define BENCH_FRAME_PAYLOAD_SIZE			32		// typical MQTT PUBLISH of a sensor
+#define BENCH_FRAME_ADDR64					((XBeeFrameAddr64::type) 0x0013A20040A1B2C3ULL)
+#define BENCH_FRAME_ADDR16					((XBeeFrameAddr16::type) 0x1234)
+#define BENCH_FRAME_PER_READ				16		// frames in one serial read
+#define BENCH_FRAME_API_ID_UNKNOWN			0x20
+#define BENCH_FRAME_NOISE_SIZE_MAX			32
+#define BENCH_FRAME_TX_SIZE_SMALL			84		// default NP of ZigBee
+#define BENCH_FRAME_TX_SIZE_BIG				255
+#define BENCH_FRAME_TIMEOUT_SEC				60
+#define BENCH_FRAME_UPLINK_ALLOCS			2		// allocations of the reassembler per good frame
+#define BENCH_FRAME_ROUTE_ALLOCS			3		// allocations of the reader per routed frame
+#define BENCH_FRAME_DROP_LOG_ALLOCS_MAX		64		// the drop summaries logged during the run
+
+
+/**
+ * Encodes the ZB_RX_RSP frame as the coordinator sends it
+ */
+static XBeeBuffer makeRxFrame(XBeeFrameApiMode::Type mode, std::size_t size) {
+	XBeeBuffer payload(size);
+	for (std::size_t i = 0; i < size; i++) {
+		payload[i] = static_cast<uint8_t>(i * 7);
+	}
+	XBeeBuffer res;
+	XBeeFrameSchema::ZbRxRsp::encode(mode, res, BENCH_FRAME_ADDR64, BENCH_FRAME_ADDR16,
+			XBeeFrameOptionsRecv::PKT_ACKED, payload.data(), payload.size());
+	return res;
+}
+
+/**
+ * Escapes the frame for API mode 2, the delimiter is kept as is
+ */
+static XBeeBuffer escape(const XBeeBuffer& frame) {
+	XBeeBuffer res(1 + 2 * (frame.size() - 1));
+	XBeeFrameSchema::EscapedWriter w(&res[0]);
+	w.putDelimiter();
+	w.put(frame.data() + 1, frame.size() - 1);
+	res.resize(w.getCursor() - &res[0]);
+	return res;
+}
+
+/**
+ * Builds the frame with the valid checksum from the API Id and the data
+ */
+static XBeeBuffer makeFrame(uint8_t apiId, const XBeeBuffer& data) {
+	XBeeBuffer res;
+	res.push_back(static_cast<uint8_t>(XBeeFrameDelimiter::VALUE));
+	res.push_back(static_cast<uint8_t>((data.size() + 1) >> 8));
+	res.push_back(static_cast<uint8_t>(data.size() + 1));
+	res.push_back(apiId);
+	res.insert(res.end(), data.begin(), data.end());
+	res.push_back(XBeeFrameChecksum::calculate(res.data() + XBEE_FRAME_HEADER_SIZE, data.size() + 1));
+	return res;
+}
+
+/**
+ * Malformed input of the given kind, API mode 2
+ *
+ * @param kind any number, the kinds are rotated
+ * @param seed state of the noise generator
+ */
+static XBeeBuffer makeMalformed(uint32_t kind, uint32_t& seed) {
+	switch (kind % 5) {
+		case 0:
+		{
+			// line noise, could contain any byte including the delimiter and the escape
+			XBeeBuffer res(1 + seed % BENCH_FRAME_NOISE_SIZE_MAX);
+			for (auto& i: res) {
+				seed = seed * 1103515245 + 12345;
+				i = static_cast<uint8_t>(seed >> 16);
+			}
+			return res;
+		}
+		case 1:
+		{
+			// wrong checksum
+			XBeeBuffer res = makeRxFrame(XBeeFrameApiMode::UNESCAPED, BENCH_FRAME_PAYLOAD_SIZE);
+			res.back()++;
+			return escape(res);
+		}
+		case 2:
+			// valid frame of the unknown API
+			return escape(makeFrame(BENCH_FRAME_API_ID_UNKNOWN, XBeeBuffer(BENCH_FRAME_PAYLOAD_SIZE, 0x55)));
+		case 3:
+		{
+			// frame cut inside the escape sequence, e.g. by the radio reset
+			XBeeBuffer res = makeRxFrame(XBeeFrameApiMode::ESCAPED, BENCH_FRAME_PAYLOAD_SIZE);
+			res.resize(res.size() / 2);
+			res.push_back(static_cast<uint8_t>(XBeeFrameEscape::ESCAPE));
+			return res;
+		}
+		default:
+			// ZB_RX_RSP without addresses
+			return escape(makeFrame(XBeeFrameApiId::ZB_RX_RSP, XBeeBuffer(2, 0x55)));
+	}
+}
+
+/**
+ * The replaced downlink encoder: the fields are appended one by one, the
+ * length is inserted after them, the checksum is summed in the second pass
+ * and every escape is inserted in the middle of the buffer.
+ * The heap allocated field objects of the old XBeeFrame are not modeled.
+ */
+static void encodeByInsert(XBeeBuffer& buffer, XBeeFrameAddr64::type addr64, const XBeeBuffer& data) {
+	buffer.clear();
+	buffer.push_back(static_cast<uint8_t>(XBeeFrameDelimiter::VALUE));
+	const std::size_t lengthStartPoint = buffer.size();
+	buffer.push_back(static_cast<uint8_t>(XBeeFrameApiId::ZB_TX_REQ));
+	buffer.push_back(static_cast<uint8_t>(XBeeFrameId::NO_RSP));
+	for (int i = 56; i >= 0; i -= 8) {
+		buffer.push_back(static_cast<uint8_t>(addr64 >> i));
+	}
+	buffer.push_back(static_cast<uint8_t>(XBeeFrameAddr16Dst::UNKNOWN >> 8));
+	buffer.push_back(static_cast<uint8_t>(XBeeFrameAddr16Dst::UNKNOWN));
+	buffer.push_back(static_cast<uint8_t>(XBeeFrameRadius::MAX));
+	buffer.push_back(0);
+	buffer.insert(buffer.end(), data.begin(), data.end());
+	const std::size_t length = buffer.size() - lengthStartPoint;
+	const uint8_t lengthBytes[] = {static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)};
+	buffer.insert(buffer.begin() + lengthStartPoint, lengthBytes, lengthBytes + sizeof(lengthBytes));
+	uint8_t checksum = 0;
+	for (auto it = buffer.begin() + lengthStartPoint + sizeof(lengthBytes); it != buffer.end(); it++) {
+		checksum += *it;
+	}
+	buffer.push_back(0xFF - checksum);
+	for (auto it = buffer.begin(); it != buffer.end(); it++) {
+		if (it == buffer.begin() || !XBeeFrameEscape::isNeeded(*it)) {
+			continue;
+		}
+		it = buffer.insert(it, static_cast<uint8_t>(XBeeFrameEscape::ESCAPE));
+		++it;
+		*it = XBeeFrameEscape::apply(*it);
+	}
+}
+
+/**
+ * Downlink encoding of the payload, old against single pass
+ */
+static void runEncode(BenchCase& c, const std::string& name, const XBeeBuffer& data) {
+	const uint64_t qty = c.getConfig().qty;
+	XBeeBuffer expected;
+	encodeByInsert(expected, BENCH_FRAME_ADDR64, data);
+	uint64_t mismatches = 0;
+	double ns[2];
+	uint64_t allocs[2];
+	for (int pass = 0; pass < 2; pass++) {
+		const uint64_t allocStart = BenchAlloc::getQty();
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < qty; i++) {
+			// the frame buffer is passed on to the port => a new one every time
+			XBeeBuffer buffer;
+			if (pass) {
+				XBeeFrameSchema::ZbTxReq::encode(XBeeFrameApiMode::ESCAPED, buffer, XBeeFrameId::NO_RSP,
+						BENCH_FRAME_ADDR64, XBeeFrameAddr16Dst::UNKNOWN, XBeeFrameRadius::MAX, 0,
+						data.data(), data.size());
+			} else {
+				encodeByInsert(buffer, BENCH_FRAME_ADDR64, data);
+			}
+			if (buffer != expected) {
+				mismatches++;
+			}
+		}
+		ns[pass] = BenchCase::getNsPerOp(start, qty);
+		allocs[pass] = BenchAlloc::getQty() - allocStart;
+	}
+	*c.log().info() << name << ": " << qty << " frames of " << data.size() << " B, escaped frame: "
+			<< expected.size() << " B"
+			<< ", ns/frame insert/single pass: " << std::fixed << std::setprecision(1) << ns[0] << "/" << ns[1]
+			<< ", allocations/frame: " << std::setprecision(2)
+			<< static_cast<double>(allocs[0]) / qty << "/" << static_cast<double>(allocs[1]) / qty;
+	c.check(!mismatches, name + ": both encoders give the same frame");
+	c.check(allocs[1] == qty, name + ": the single pass encoder allocates the frame buffer only");
+}
+
+/**
+ * Uplink handling of the reassembled frame as XBeeNet::onFrame does:
+ * decode in place and cut the checksum off the same buffer
+ *
+ * @param offset start of the payload after the frame header
+ * @return false if the frame is not a valid ZB_RX_RSP
+ */
+static bool takePayload(XBeeBuffer& buffer, std::size_t& offset) {
+	XBeeFrameView frame;
+	if (frame.decode(buffer) != XBeeFrameStatus::OK
+			|| frame.getApiId() != XBeeFrameApiId::ZB_RX_RSP
+			|| frame.get<XBeeFrameSchema::ZbRxRsp, XBeeFrameSchema::Addr64>() != BENCH_FRAME_ADDR64)
+	{
+		return false;
+	}
+	offset = frame.getDataOffset();
+	buffer.resize(offset + frame.getDataSize());
+	return true;
+}
+
+/**
+ * Destination of the routed uplink units, updated by the processor thread only
+ */
+struct BenchFrameSink {
+	uint64_t										bytes;
+	std::atomic<uint64_t>							done;
+
+	BenchFrameSink(): bytes(0), done(0) {}
+};
+
+static BenchFrameSink* gBenchFrameSink = NULL;
+
+namespace Networking {
+
+/**
+ * Route of the uplink unit: the payload is passed on as TcpNet::send() takes it
+ */
+template<> void DataUnitXBee::execute() {
+	std::unique_ptr<Buffer> data = popData();
+	gBenchFrameSink->bytes += data->size() - getOffset();
+	gBenchFrameSink->done.fetch_add(1, std::memory_order_release);
+}
+
+} /* namespace Networking */
+
+/**
+ * Reads the allocations counter on the processor thread
+ */
+class BenchFrameCommandAllocs: public Utils::Command {
+public:
+	BenchFrameCommandAllocs(std::atomic<uint64_t>& qty): mQty(qty) {}
+
+	void execute() {
+		mQty.store(BenchAlloc::getQty(), std::memory_order_release);
+	}
+private:
+	std::atomic<uint64_t>&							mQty;
+};
+
+/**
+ * Pushes the serial reads through the reassembler and decodes the frames
+ *
+ * @return nanoseconds per good frame
+ */
+static double runUplink(BenchCase& c, const std::string& name, XBeeFrameApiMode::Type mode,
+		const XBeeBuffer& read, uint64_t goodPerRead, uint64_t badPerRead)
+{
+	const uint64_t reads = c.getConfig().qty / goodPerRead;
+	const uint64_t frames = reads * goodPerRead;
+	uint64_t decoded = 0;
+	uint64_t rejected = 0;
+	std::unique_ptr<XBeeBuffer> payload;
+	XBeeNetFromBuffer fromBuffer("bench", mode,
+		[&decoded, &rejected, &payload] (std::unique_ptr<XBeeBuffer> a) {
+			std::size_t offset = 0;
+			if (takePayload(*a, offset)) {
+				decoded++;
+			} else {
+				rejected++;
+			}
+			// the data unit owns the payload till the next frame
+			payload = std::move(a);
+		}
+	);
+	const uint64_t allocStart = BenchAlloc::getQty();
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < reads; i++) {
+		fromBuffer.push(read);
+	}
+	const double ns = BenchCase::getNsPerOp(start, frames);
+	const uint64_t allocs = BenchAlloc::getQty() - allocStart;
+	*c.log().info() << name << ": " << frames << " good frames, " << badPerRead * reads << " malformed"
+			<< ", ns/good frame: " << std::fixed << std::setprecision(1) << ns
+			<< ", allocations/good frame: " << std::setprecision(4)
+			<< (frames ? static_cast<double>(allocs) / frames : 0)
+			<< ", rejected by decoder: " << rejected;
+	c.check(decoded == frames, name + ": every good frame is reassembled and decoded");
+	// the frames rejected by the decoder are whole frames for the reassembler
+	c.check(allocs <= (frames + rejected) * BENCH_FRAME_UPLINK_ALLOCS + BENCH_FRAME_DROP_LOG_ALLOCS_MAX,
+			name + ": dropping the malformed input doesn't allocate");
+	return ns;
+}
+
+/**
+ * Serial reads => reassembler => decoding => data unit => router processor => route,
+ * as XBeeNet and the threaded Router do. Allocations are counted on both threads.
+ */
+static void runRoute(BenchCase& c, const std::string& name, const XBeeBuffer& read, uint64_t goodPerRead) {
+	const uint64_t reads = c.getConfig().qty / goodPerRead;
+	const uint64_t frames = reads * goodPerRead;
+	const Networking::AddressXBeeNet* from = Networking::AddressXBeeNet::intern(BENCH_FRAME_ADDR64);
+	BenchFrameSink sink;
+	gBenchFrameSink = &sink;
+	Utils::CommandProcessor processor(name);
+	uint64_t decoded = 0;
+	XBeeNetFromBuffer fromBuffer("bench", XBeeFrameApiMode::ESCAPED,
+		[&decoded, &processor, from] (std::unique_ptr<XBeeBuffer> a) {
+			std::size_t offset = 0;
+			if (takePayload(*a, offset)) {
+				decoded++;
+				processor.process(std::unique_ptr<Networking::DataUnit>(
+						new Networking::DataUnitXBee(std::move(a), from, NULL, offset)));
+			}
+		}
+	);
+	std::atomic<uint64_t> processorStart(0);
+	std::atomic<uint64_t> processorEnd(0);
+	processor.start();
+	processor.process(std::unique_ptr<Utils::Command>(new BenchFrameCommandAllocs(processorStart)));
+	const uint64_t allocStart = BenchAlloc::getQty();
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < reads; i++) {
+		fromBuffer.push(read);
+	}
+	const uint64_t allocs = BenchAlloc::getQty() - allocStart;
+	const std::chrono::steady_clock::time_point deadline =
+			start + std::chrono::seconds(BENCH_FRAME_TIMEOUT_SEC);
+	while (sink.done.load(std::memory_order_acquire) < frames && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+	const double ns = BenchCase::getNsPerOp(start, frames);
+	processor.process(std::unique_ptr<Utils::Command>(new BenchFrameCommandAllocs(processorEnd)));
+	while (!processorEnd.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+	processor.stop();
+	gBenchFrameSink = NULL;
+	const uint64_t processorAllocs = processorEnd.load() - processorStart.load();
+	*c.log().info() << name << ": " << frames << " frames, ns/frame: " << std::fixed << std::setprecision(1) << ns
+			<< ", allocations/frame reader/router: " << std::setprecision(4)
+			<< (frames ? static_cast<double>(allocs) / frames : 0) << "/"
+			<< (frames ? static_cast<double>(processorAllocs) / frames : 0);
+	c.check(decoded == frames && sink.done.load() == frames
+			&& sink.bytes == frames * BENCH_FRAME_PAYLOAD_SIZE, name + ": every frame is routed with its payload");
+	c.check(allocs == frames * BENCH_FRAME_ROUTE_ALLOCS,
+			name + ": the frame buffer, its storage and the data unit are the only allocations of the reader");
+	// the queue of the processor grows by blocks
+	c.check(processorAllocs * BENCH_FRAME_PER_READ < frames, name + ": routing of the unit doesn't allocate");
+}
+
+void benchDecode(BenchCase& c) {
+	const uint64_t qty = c.getConfig().qty;
+	// decoding only
+	{
+		const XBeeBuffer frame = makeRxFrame(XBeeFrameApiMode::UNESCAPED, BENCH_FRAME_PAYLOAD_SIZE);
+		XBeeBuffer buffer;
+		buffer.reserve(frame.size());
+		uint64_t decoded = 0;
+		const uint64_t allocStart = BenchAlloc::getQty();
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < qty; i++) {
+			buffer.assign(frame.begin(), frame.end());
+			std::size_t offset = 0;
+			if (takePayload(buffer, offset) && buffer.size() - offset == BENCH_FRAME_PAYLOAD_SIZE) {
+				decoded++;
+			}
+		}
+		const double ns = BenchCase::getNsPerOp(start, qty);
+		const uint64_t allocs = BenchAlloc::getQty() - allocStart;
+		*c.log().info() << "decode: " << qty << " frames, ns/frame: " << std::fixed << std::setprecision(1) << ns
+				<< ", allocations/frame: " << std::setprecision(4) << (qty ? static_cast<double>(allocs) / qty : 0);
+		c.check(decoded == qty, "decode: every frame is decoded");
+		c.check(allocs == 0, "decode: decoding and the payload cut don't allocate");
+	}
+	// serial reads => reassembler => decoding, the frame buffer is passed on as the payload
+	XBeeBuffer read;
+	for (uint32_t i = 0; i < BENCH_FRAME_PER_READ; i++) {
+		const XBeeBuffer frame = makeRxFrame(XBeeFrameApiMode::ESCAPED, BENCH_FRAME_PAYLOAD_SIZE);
+		read.insert(read.end(), frame.begin(), frame.end());
+	}
+	runUplink(c, "uplink", XBeeFrameApiMode::ESCAPED, read, BENCH_FRAME_PER_READ, 0);
+	// the logs below the level are not built
+	runRoute(c, "route", read, BENCH_FRAME_PER_READ);
+}
+
+void benchResync(BenchCase& c) {
+	const XBeeBuffer good = makeRxFrame(XBeeFrameApiMode::ESCAPED, BENCH_FRAME_PAYLOAD_SIZE);
+	// status path of the decoder
+	{
+		const uint64_t qty = c.getConfig().qty;
+		const XBeeBuffer unknown = makeFrame(BENCH_FRAME_API_ID_UNKNOWN, XBeeBuffer(BENCH_FRAME_PAYLOAD_SIZE, 0x55));
+		const XBeeBuffer shortRx = makeFrame(XBeeFrameApiId::ZB_RX_RSP, XBeeBuffer(2, 0x55));
+		uint64_t rejected = 0;
+		const uint64_t allocStart = BenchAlloc::getQty();
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < qty; i++) {
+			XBeeFrameView frame;
+			if (frame.decode((i % 2) ? unknown : shortRx) != XBeeFrameStatus::OK) {
+				rejected++;
+			}
+		}
+		const double ns = BenchCase::getNsPerOp(start, qty);
+		const uint64_t allocs = BenchAlloc::getQty() - allocStart;
+		*c.log().info() << "reject: " << qty << " malformed frames, ns/frame: " << std::fixed << std::setprecision(1) << ns
+				<< ", allocations/frame: " << std::setprecision(4) << (qty ? static_cast<double>(allocs) / qty : 0);
+		c.check(rejected == qty, "reject: every malformed frame is rejected");
+		c.check(allocs == 0, "reject: rejecting doesn't allocate");
+	}
+	// good frames only
+	XBeeBuffer read;
+	for (uint32_t i = 0; i < BENCH_FRAME_PER_READ; i++) {
+		read.insert(read.end(), good.begin(), good.end());
+	}
+	const double clean = runUplink(c, "clean", XBeeFrameApiMode::ESCAPED, read, BENCH_FRAME_PER_READ, 0);
+	// every good frame follows the malformed input
+	read.clear();
+	uint32_t seed = 1;
+	for (uint32_t i = 0; i < BENCH_FRAME_PER_READ; i++) {
+		const XBeeBuffer bad = makeMalformed(i, seed);
+		read.insert(read.end(), bad.begin(), bad.end());
+		read.insert(read.end(), good.begin(), good.end());
+	}
+	const double noisy = runUplink(c, "noisy", XBeeFrameApiMode::ESCAPED, read,
+			BENCH_FRAME_PER_READ, BENCH_FRAME_PER_READ);
+	*c.log().info() << "noisy/clean time per good frame: " << std::fixed << std::setprecision(2)
+			<< (clean ? noisy / clean : 0);
+	// API mode 1: the cut frame swallows the start of the next one => resync inside the dropped frame
+	const XBeeBuffer plain = makeRxFrame(XBeeFrameApiMode::UNESCAPED, BENCH_FRAME_PAYLOAD_SIZE);
+	read.clear();
+	for (uint32_t i = 0; i < BENCH_FRAME_PER_READ; i++) {
+		read.insert(read.end(), plain.begin(), plain.begin() + plain.size() / 2);
+		read.insert(read.end(), plain.begin(), plain.end());
+	}
+	runUplink(c, "cut", XBeeFrameApiMode::UNESCAPED, read, BENCH_FRAME_PER_READ, BENCH_FRAME_PER_READ);
+}
+
+void benchEncode(BenchCase& c) {
+	XBeeBuffer plain(BENCH_FRAME_TX_SIZE_SMALL);
+	for (std::size_t i = 0; i < plain.size(); i++) {
+		plain[i] = static_cast<uint8_t>(0x20 + i % 0x50);
+	}
+	runEncode(c, "plain", plain);
+	const uint8_t controls[] = {
+		XBeeFrameDelimiter::VALUE, XBeeFrameEscape::ESCAPE, XBeeFrameEscape::XON, XBeeFrameEscape::XOFF
+	};
+	for (std::size_t size: {BENCH_FRAME_TX_SIZE_SMALL, BENCH_FRAME_TX_SIZE_BIG}) {
+		XBeeBuffer escaped(size);
+		for (std::size_t i = 0; i < escaped.size(); i++) {
+			escaped[i] = controls[i % sizeof(controls)];
+		}
+		runEncode(c, "escaped", escaped);
+	}
+}
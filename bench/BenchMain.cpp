@@ -0,0 +1,127 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. Main function.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "BenchCase.h"
+#include "Logger.h"
+#include "LogManager.h"
+#include "Configuration.h"
+#include "Error.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <vector>
+#include <boost/program_options.hpp>
+
+
+/**
+ * Benchmark cases, run in this order
+ */
+static const struct {
+	const char*										name;
+	void											(*run)(BenchCase&);
+} BENCH_CASES[] = {
+	{"processor",		benchProcessor},
+	{"decode",			benchDecode},
+	{"resync",			benchResync},
+	{"encode",			benchEncode},
+	{"serial",			benchSerial},
+	{"route",			benchRoute},
+	{"tx",				benchTx},
+};
+
+int main(int argc, char* argv[]) {
+	Utils::Logger log("BenchMain");
+	int res = 0;
+	try {
+		BenchConfig config;
+		std::vector<std::string> names;
+		std::string logLevel;
+		boost::program_options::options_description desc("Benchmark options");
+		desc.add_options()
+			("help,h", "Show help")
+			("case,c", boost::program_options::value<std::vector<std::string> >(&names),
+				"Case to run, could be repeated; all cases by default")
+			("qty,n", boost::program_options::value<uint32_t>(&config.qty)->default_value(100000),
+				"Operations per measurement")
+			("producers", boost::program_options::value<uint32_t>(&config.producers)->default_value(4),
+				"Threads feeding the command processors")
+			("wakeups", boost::program_options::value<uint32_t>(&config.wakeups)->default_value(1000),
+				"Wake-up latency samples")
+			("log-level", boost::program_options::value<std::string>(&logLevel)->default_value("INFO"),
+				"ERROR, WARN, INFO, DEBUG or TRACE")
+		;
+		try {
+			boost::program_options::variables_map vm;
+			boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
+			if (vm.count("help")) {
+				*log.info() << desc;
+				std::string list;
+				for (const auto& i: BENCH_CASES) {
+					list += std::string(" ") + i.name;
+				}
+				*log.info() << "Cases:" << list;
+				throw Utils::Error(Utils::ErrorCode::OK, "help has been requested");
+			}
+			boost::program_options::notify(vm);
+			for (const auto& name: names) {
+				bool isKnown = false;
+				for (const auto& i: BENCH_CASES) {
+					isKnown = isKnown || name == i.name;
+				}
+				if (!isKnown) {
+					throw Utils::Error("case, wrong value [" + name + "]");
+				}
+			}
+			Utils::Configuration::get().logger.level = Utils::LoggerLevel::fromString(logLevel);
+		} catch (Utils::Error& e) {
+			throw;
+		} catch (std::exception& e) {
+			*log.info() << desc;
+			throw Utils::Error(e, "Options");
+		}
+		Utils::LogManager::get().start();
+		for (const auto& i: BENCH_CASES) {
+			bool isSelected = names.empty();
+			for (const auto& name: names) {
+				isSelected = isSelected || name == i.name;
+			}
+			if (!isSelected) {
+				continue;
+			}
+			BenchCase c(i.name, config);
+			*log.info() << "Case: " << i.name;
+			i.run(c);
+			if (c.isFailed()) {
+				res = 1;
+			}
+		}
+		if (res) {
+			*log.error() << "Some checks have failed";
+		}
+	} catch (Utils::Error& e) {
+		if (e.getCode() == Utils::ErrorCode::OK) {
+			*log.info() << e.what();
+		} else {
+			*log.error() << e.what();
+			res = 1;
+		}
+	} catch (std::exception& e) {
+		*log.error() << e.what();
+		res = 1;
+	}
+	// It was the last log => flush everything in logger
+	Utils::Configuration::destroy();
+	Utils::LogManager::destroy();
+	return res;
+}
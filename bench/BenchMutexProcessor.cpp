@@ -0,0 +1,167 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. Command processor with the mutex protected queue.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "BenchMutexProcessor.h"
+#include "Error.h"
+/* External Includes */
+/* System Includes */
+#include <assert.h>
+
+
+static const uint64_t NO_STREAM = Utils::CommandProcessor::NO_STREAM;
+
+BenchMutexProcessor::BenchMutexProcessor(const std::string& name)
+:
+	Utils::Thread(name + "-MxP"),
+	mLog(getName()),
+	mSem(0, 1)
+{
+}
+
+BenchMutexProcessor::~BenchMutexProcessor() throw () {
+	_stop();
+	while (!mQueueHigh.empty()) {
+		delete mQueueHigh.front();
+		mQueueHigh.pop();
+	}
+	while (!mQueue.empty()) {
+		delete mQueue.front().cmd;
+		mQueue.pop();
+	}
+	for (auto& i: mDelayed) {
+		delete i.second;
+	}
+	mDelayed.clear();
+}
+
+void BenchMutexProcessor::stop(void) {
+	*mLog.debug() << UTILS_STR_FUNCTION;
+	_stop();
+}
+
+void BenchMutexProcessor::_stop(void) {
+	Utils::Thread::stop();
+}
+
+void BenchMutexProcessor::start(void)
+{
+	*mLog.debug() << UTILS_STR_FUNCTION;
+	Utils::Thread::start();
+}
+
+void BenchMutexProcessor::onStop() {
+	mSem.post();
+}
+
+void BenchMutexProcessor::loop(void)
+{
+	while (isAlive()) {
+		// wait a new command or the nearest delayed one
+		mMtx.lock();
+		if (mDelayed.empty()) {
+			mMtx.unlock();
+			mSem.wait();
+		} else {
+			const std::chrono::steady_clock::time_point due = mDelayed.begin()->first;
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			mMtx.unlock();
+			if (due > now) {
+				mSem.wait(static_cast<uint32_t>(
+						std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count() + 1));
+			}
+		}
+		mMtx.lock();
+		// move due delayed commands to the queue
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		while (!mDelayed.empty() && mDelayed.begin()->first <= now) {
+			mQueue.push(Item{mDelayed.begin()->second, NO_STREAM});
+			mDelayed.erase(mDelayed.begin());
+		}
+		//process all commands
+		while (!mQueueHigh.empty() || !mQueue.empty()) {
+			std::unique_ptr<Utils::Command> cmd(pop());
+			// release mutex to allow adding new commands
+			mMtx.unlock();
+			try {
+				cmd->execute();
+			} catch (std::exception &e) {
+				*mLog.error() << UTILS_STR_FUNCTION
+						<<", Command::execute, error: " << e.what();
+			}
+			mMtx.lock();
+		}
+		mMtx.unlock();
+	}
+	*mLog.debug() << UTILS_STR_FUNCTION << ", done";
+}
+
+Utils::Command* BenchMutexProcessor::pop()
+{
+	// strict priority
+	if (!mQueueHigh.empty()) {
+		Utils::Command* cmd = mQueueHigh.front();
+		mQueueHigh.pop();
+		return cmd;
+	}
+	const Item item = mQueue.front();
+	mQueue.pop();
+	if (item.stream != NO_STREAM) {
+		auto it = mPending.find(item.stream);
+		if (it != mPending.end() && --it->second == 0) {
+			mPending.erase(it);
+		}
+	}
+	return item.cmd;
+}
+
+void BenchMutexProcessor::process(std::unique_ptr<Utils::Command> command)
+{
+	process(std::move(command), Lane::NORMAL, NO_STREAM);
+}
+
+void BenchMutexProcessor::process(std::unique_ptr<Utils::Command> command, Lane::Type lane, uint64_t stream)
+{
+	assert(command.get());
+	if (command.get()) {
+		std::lock_guard<std::mutex> locker(mMtx);
+		if (lane == Lane::HIGH && stream != NO_STREAM && mPending.count(stream)) {
+			// keep the stream order
+			lane = Lane::NORMAL;
+		}
+		if (lane == Lane::HIGH) {
+			mQueueHigh.push(command.get());
+		} else {
+			mQueue.push(Item{command.get(), stream});
+			if (stream != NO_STREAM) {
+				++mPending[stream];
+			}
+		}
+		command.release();
+		mSem.post();
+	}
+}
+
+void BenchMutexProcessor::process(std::unique_ptr<Utils::Command> command, uint32_t delayMs)
+{
+	assert(command.get());
+	if (command.get()) {
+		std::lock_guard<std::mutex> locker(mMtx);
+		mDelayed.insert(std::make_pair(
+				std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs),
+				command.get()));
+		command.release();
+		// wake up to recalculate the waiting time
+		mSem.post();
+	}
+}
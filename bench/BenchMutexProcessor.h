@@ -0,0 +1,83 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. Command processor with the mutex protected queue.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef BENCH_MUTEX_PROCESSOR_H_
+#define BENCH_MUTEX_PROCESSOR_H_
+
+/* Internal Includes */
+#include "Thread.h"
+#include "Command.h"
+#include "CommandProcessor.h"
+#include "Semaphore.h"
+#include "Logger.h"
+/* External Includes */
+/* System Includes */
+#include <string>
+#include <queue>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+
+
+/**
+ * The baseline of Utils::CommandProcessor: the same lanes, streams and
+ * delayed commands, but every command goes through one mutex protected
+ * std::queue and a Utils::Semaphore post.
+ */
+class BenchMutexProcessor: private Utils::Thread {
+public:
+	typedef Utils::CommandProcessor::Lane Lane;
+
+	BenchMutexProcessor(const std::string&);
+
+	~BenchMutexProcessor() throw ();
+
+	void start(void);
+
+	void stop(void);
+
+	void process(std::unique_ptr<Utils::Command>);
+
+	void process(std::unique_ptr<Utils::Command>, uint32_t delayMs);
+
+	void process(std::unique_ptr<Utils::Command>, Lane::Type lane, uint64_t stream);
+
+private:
+	// Types
+	struct Item {
+		Utils::Command*	cmd;
+		uint64_t		stream;
+	};
+	// Objects
+	Utils::Logger					mLog;
+	std::queue<Utils::Command*>		mQueueHigh;
+	std::queue<Item>				mQueue;
+	// number of commands in the normal lane per stream
+	std::unordered_map<uint64_t, uint32_t>	mPending;
+	std::multimap<std::chrono::steady_clock::time_point, Utils::Command*>	mDelayed;
+	Utils::Semaphore				mSem;
+	std::mutex						mMtx;
+
+	// Do not copy
+	BenchMutexProcessor(const BenchMutexProcessor&);
+	BenchMutexProcessor &operator=(const BenchMutexProcessor&);
+
+	// Internal
+	void onStop();
+	void loop();
+	void _stop(void);
+	Utils::Command* pop();
+};
+
+#endif /* BENCH_MUTEX_PROCESSOR_H_ */
@@ -0,0 +1,219 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. Command processors.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "BenchCase.h"
+#include "BenchAlloc.h"
+#include "BenchMutexProcessor.h"
+#include "CommandProcessor.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+
+#define BENCH_PROCESSOR_TIMEOUT_SEC			60
+#define BENCH_PROCESSOR_HIGH_PERIOD			8		// every Nth command goes to the high lane
+#define BENCH_PROCESSOR_IDLE_MS				1		// pause between the wake-up samples
+
+
+/**
+ * Results of the command sequences.
+ * Updated by the processor thread only, the counter is read by the producer.
+ */
+struct BenchProcessorSeq {
+	std::vector<uint64_t>							last;		// last sequence number of every stream
+	uint64_t										reordered;
+	uint64_t										allocStart;	// processor thread allocations
+	uint64_t										allocEnd;
+	std::atomic<uint64_t>							done;
+
+	BenchProcessorSeq(uint32_t streams): last(streams, 0), reordered(0), allocStart(0), allocEnd(0), done(0) {}
+};
+
+class BenchProcessorCommandSeq: public Utils::Command {
+public:
+	BenchProcessorCommandSeq(BenchProcessorSeq& seq, uint32_t stream, uint64_t value)
+	: mSeq(seq), mStream(stream), mValue(value) {}
+
+	void execute() {
+		if (!mSeq.done.load(std::memory_order_relaxed)) {
+			mSeq.allocStart = BenchAlloc::getQty();
+		}
+		if (mValue <= mSeq.last[mStream]) {
+			mSeq.reordered++;
+		}
+		mSeq.last[mStream] = mValue;
+		mSeq.allocEnd = BenchAlloc::getQty();
+		mSeq.done.fetch_add(1, std::memory_order_release);
+	}
+private:
+	BenchProcessorSeq&								mSeq;
+	const uint32_t									mStream;
+	const uint64_t									mValue;
+};
+
+class BenchProcessorCommandWakeUp: public Utils::Command {
+public:
+	BenchProcessorCommandWakeUp(std::atomic<int64_t>& latencyNs)
+	: mLatencyNs(latencyNs), mStart(std::chrono::steady_clock::now()) {}
+
+	void execute() {
+		mLatencyNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - mStart).count(), std::memory_order_release);
+	}
+private:
+	std::atomic<int64_t>&							mLatencyNs;
+	const std::chrono::steady_clock::time_point		mStart;
+};
+
+class BenchProcessorCommandNop: public Utils::Command {
+public:
+	void execute() {}
+};
+
+/**
+ * Waits till the counter reaches the value
+ *
+ * @return false on timeout
+ */
+template<typename tValue>
+static bool waitFor(const std::atomic<tValue>& counter, tValue value) {
+	const std::chrono::steady_clock::time_point deadline =
+			std::chrono::steady_clock::now() + std::chrono::seconds(BENCH_PROCESSOR_TIMEOUT_SEC);
+	while (counter.load(std::memory_order_acquire) < value) {
+		if (std::chrono::steady_clock::now() > deadline) {
+			return false;
+		}
+		std::this_thread::yield();
+	}
+	return true;
+}
+
+/**
+ * Producers push sequences to their own streams, every Nth command goes to
+ * the high lane. The processor checks that no stream is reordered.
+ */
+template<typename tProcessor>
+static void benchThroughput(BenchCase& c, const std::string& name) {
+	const uint32_t producers = c.getConfig().producers;
+	const uint64_t qty = c.getConfig().qty;
+	const uint64_t total = qty * producers;
+	tProcessor processor(name);
+	processor.start();
+	BenchProcessorSeq seq(producers);
+	std::atomic<uint64_t> allocs(0);
+	std::atomic<uint32_t> ready(0);
+	std::atomic<bool> isGo(false);
+	std::vector<std::thread> threads;
+	for (uint32_t p = 0; p < producers; p++) {
+		threads.push_back(std::thread([&processor, &seq, &allocs, &ready, &isGo, p, qty] () {
+			// the commands are created in advance => only the queuing is measured
+			std::vector<std::unique_ptr<Utils::Command> > cmds;
+			cmds.reserve(qty);
+			for (uint64_t i = 1; i <= qty; i++) {
+				cmds.push_back(std::unique_ptr<Utils::Command>(new BenchProcessorCommandSeq(seq, p, i)));
+			}
+			ready.fetch_add(1);
+			while (!isGo.load()) {
+				std::this_thread::yield();
+			}
+			const uint64_t allocStart = BenchAlloc::getQty();
+			for (uint64_t i = 1; i <= qty; i++) {
+				processor.process(std::move(cmds[i - 1]),
+						(i % BENCH_PROCESSOR_HIGH_PERIOD) ? Utils::CommandProcessor::Lane::NORMAL
+								: Utils::CommandProcessor::Lane::HIGH,
+						p + 1);
+			}
+			allocs.fetch_add(BenchAlloc::getQty() - allocStart);
+		}));
+	}
+	waitFor<uint32_t>(ready, producers);
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	isGo.store(true);
+	for (auto& i: threads) {
+		i.join();
+	}
+	const bool isDone = waitFor<uint64_t>(seq.done, total);
+	const double ns = BenchCase::getNsPerOp(start, total);
+	processor.stop();
+	*c.log().info() << name << ": " << total << " commands from " << producers << " producers"
+			<< ", ns/command: " << std::fixed << std::setprecision(1) << ns
+			<< ", producer allocations/command: " << std::setprecision(4)
+			<< static_cast<double>(allocs.load()) / total
+			<< ", processor allocations/command: "
+			<< static_cast<double>(seq.allocEnd - seq.allocStart) / total;
+	c.check(isDone, name + ": all commands are executed");
+	c.check(isDone && !seq.reordered, name + ": no stream is reordered");
+}
+
+/**
+ * Latency from the push till the execution by the idle processor
+ */
+template<typename tProcessor>
+static void benchWakeUp(BenchCase& c, const std::string& name) {
+	const uint32_t qty = c.getConfig().wakeups;
+	tProcessor processor(name);
+	processor.start();
+	std::atomic<int64_t> latencyNs(0);
+	int64_t sumNs = 0;
+	int64_t maxNs = 0;
+	bool isDone = true;
+	for (uint32_t i = 0; i < qty && isDone; i++) {
+		// let the processor fall asleep
+		std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_PROCESSOR_IDLE_MS));
+		latencyNs.store(-1);
+		processor.process(std::unique_ptr<Utils::Command>(new BenchProcessorCommandWakeUp(latencyNs)));
+		isDone = waitFor<int64_t>(latencyNs, 0);
+		sumNs += latencyNs;
+		maxNs = std::max<int64_t>(maxNs, latencyNs);
+	}
+	processor.stop();
+	*c.log().info() << name << ": wake-up us avg/max: " << std::fixed << std::setprecision(1)
+			<< (qty ? sumNs / 1000.0 / qty : 0) << "/" << maxNs / 1000.0;
+	c.check(isDone, name + ": every wake-up is executed");
+}
+
+/**
+ * Allocations of the producer per queued command
+ */
+template<typename tProcessor>
+static double getEnqueueAllocs(BenchCase& c, const std::string& name) {
+	const uint64_t qty = c.getConfig().qty;
+	// not started => commands stay queued and are deleted by the destructor
+	tProcessor processor(name);
+	std::vector<std::unique_ptr<Utils::Command> > cmds;
+	cmds.reserve(qty);
+	for (uint64_t i = 0; i < qty; i++) {
+		cmds.push_back(std::unique_ptr<Utils::Command>(new BenchProcessorCommandNop));
+	}
+	const uint64_t allocStart = BenchAlloc::getQty();
+	for (auto& i: cmds) {
+		processor.process(std::move(i));
+	}
+	const double res = qty ? static_cast<double>(BenchAlloc::getQty() - allocStart) / qty : 0;
+	*c.log().info() << name << ": enqueue allocations/command: " << std::fixed << std::setprecision(4) << res;
+	return res;
+}
+
+void benchProcessor(BenchCase& c) {
+	benchThroughput<BenchMutexProcessor>(c, "mutex");
+	benchThroughput<Utils::CommandProcessor>(c, "mpsc");
+	benchWakeUp<BenchMutexProcessor>(c, "mutex");
+	benchWakeUp<Utils::CommandProcessor>(c, "mpsc");
+	getEnqueueAllocs<BenchMutexProcessor>(c, "mutex");
+	c.check(getEnqueueAllocs<Utils::CommandProcessor>(c, "mpsc") == 0, "mpsc: enqueue doesn't allocate");
+}
@@ -0,0 +1,157 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. Router hop of the data units.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "BenchCase.h"
+#include "BenchAlloc.h"
+#include "CommandProcessor.h"
+#include "NetworkingDataUnit.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <iomanip>
+
+#define BENCH_ROUTE_PAYLOAD_SIZE			32
+#define BENCH_ROUTE_TIMEOUT_SEC				60
+
+
+/**
+ * Destination of the routed units, updated by the processor thread only
+ */
+struct BenchRouteSink {
+	uint64_t										bytes;
+	std::atomic<uint64_t>							done;
+
+	BenchRouteSink(): bytes(0), done(0) {}
+};
+
+/**
+ * XBee network unit, the route is the type of the unit as in
+ * Networking::DataUnitImpl<Origin>
+ */
+class BenchRouteUnit: public Networking::DataUnit {
+public:
+	BenchRouteUnit(BenchRouteSink& sink, std::unique_ptr<Networking::Buffer> data)
+	:
+		Networking::DataUnit(Networking::Origin::XBEE, NULL, NULL),
+		mSink(sink),
+		mData(std::move(data))
+	{}
+
+	void execute() {
+		route();
+	}
+
+	void route() {
+		mSink.bytes += mData->size();
+		mSink.done.fetch_add(1, std::memory_order_release);
+	}
+private:
+	BenchRouteSink&									mSink;
+	std::unique_ptr<Networking::Buffer>				mData;
+};
+
+/**
+ * The replaced router command: wraps the unit and the callback
+ */
+class BenchRouteCommandProcess: public Utils::Command {
+public:
+	typedef std::function<void(std::unique_ptr<Networking::DataUnit>)> Cbk;
+	BenchRouteCommandProcess(Cbk cbk, std::unique_ptr<Networking::DataUnit> data)
+	:
+		mCbk(cbk),
+		mData(std::move(data))
+	{}
+
+	void execute() {
+		mCbk(std::move(mData));
+	}
+private:
+	Cbk												mCbk;
+	std::unique_ptr<Networking::DataUnit>			mData;
+};
+
+/**
+ * The replaced route selection: switch by origin and cast
+ */
+static void routeByOrigin(std::unique_ptr<Networking::DataUnit> unit) {
+	switch (unit->getOrigin()) {
+		case Networking::Origin::XBEE:
+		{
+			BenchRouteUnit* u = dynamic_cast<BenchRouteUnit*>(unit.get());
+			if (u) {
+				u->route();
+			}
+		}
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Routes the units through the started processor
+ *
+ * @param isWrapped true => the replaced command with the callback
+ * @return allocations of the router hop
+ */
+static uint64_t runRoute(BenchCase& c, const std::string& name, bool isWrapped) {
+	const uint64_t qty = c.getConfig().qty;
+	BenchRouteSink sink;
+	// the units are made by XBeeNet => created in advance, only the hop is measured
+	std::vector<std::unique_ptr<Networking::DataUnit> > units;
+	units.reserve(qty);
+	for (uint64_t i = 0; i < qty; i++) {
+		units.push_back(std::unique_ptr<Networking::DataUnit>(new BenchRouteUnit(sink,
+				std::unique_ptr<Networking::Buffer>(new Networking::Buffer(BENCH_ROUTE_PAYLOAD_SIZE)))));
+	}
+	Utils::CommandProcessor processor(name);
+	processor.start();
+	const uint64_t allocStart = BenchAlloc::getQty();
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (auto& i: units) {
+		if (isWrapped) {
+			processor.process(std::unique_ptr<Utils::Command>(new BenchRouteCommandProcess(
+				[] (std::unique_ptr<Networking::DataUnit> a) {
+					routeByOrigin(std::move(a));
+				},
+				std::move(i)
+			)));
+		} else {
+			processor.process(std::move(i));
+		}
+	}
+	const uint64_t allocs = BenchAlloc::getQty() - allocStart;
+	const std::chrono::steady_clock::time_point deadline =
+			start + std::chrono::seconds(BENCH_ROUTE_TIMEOUT_SEC);
+	while (sink.done.load(std::memory_order_acquire) < qty && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+	const double ns = BenchCase::getNsPerOp(start, qty);
+	processor.stop();
+	*c.log().info() << name << ": " << qty << " units, ns/unit: " << std::fixed << std::setprecision(1) << ns
+			<< ", hop allocations/unit: " << std::setprecision(4) << (qty ? static_cast<double>(allocs) / qty : 0);
+	c.check(sink.done.load() == qty && sink.bytes == qty * BENCH_ROUTE_PAYLOAD_SIZE,
+			name + ": every unit is routed");
+	return allocs;
+}
+
+void benchRoute(BenchCase& c) {
+	runRoute(c, "wrapped", true);
+	c.check(!runRoute(c, "direct", false), "direct: the router hop doesn't allocate");
+}
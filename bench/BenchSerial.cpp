@@ -0,0 +1,129 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. Serial port read buffers.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "BenchCase.h"
+#include "BenchAlloc.h"
+#include "BufferPool.h"
+#include "NetworkingAddress.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <iomanip>
+
+// the same as the serial port reader
+#define BENCH_SERIAL_READ_SIZE				512
+#define BENCH_SERIAL_POOL_SIZE				64
+// received bytes per read and reads on the way to XBeeNet
+#define BENCH_SERIAL_RECEIVED_SIZE			100
+#define BENCH_SERIAL_IN_FLIGHT				8
+
+
+typedef std::unique_ptr< std::vector<uint8_t> > BenchSerialBuffer;
+
+/**
+ * Reads through the ring of the buffers on the way: every read takes
+ * a buffer and the oldest one is handed back as XBeeNet does
+ *
+ * @param tRead function making the received buffer
+ * @param tRecycle function taking back the processed buffer
+ * @param allocs allocations of the steady state reads
+ * @return nanoseconds per read
+ */
+template<typename tRead, typename tRecycle>
+static double runReads(BenchCase& c, const std::string& name, tRead read, tRecycle recycle, uint64_t& allocs) {
+	const uint64_t qty = c.getConfig().qty;
+	std::vector<BenchSerialBuffer> inFlight(BENCH_SERIAL_IN_FLIGHT);
+	// the warm-up fills the pool
+	for (uint32_t i = 0; i < BENCH_SERIAL_IN_FLIGHT * 2; i++) {
+		BenchSerialBuffer& slot = inFlight[i % BENCH_SERIAL_IN_FLIGHT];
+		recycle(std::move(slot));
+		slot = read();
+	}
+	const uint64_t allocStart = BenchAlloc::getQty();
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < qty; i++) {
+		BenchSerialBuffer& slot = inFlight[i % BENCH_SERIAL_IN_FLIGHT];
+		recycle(std::move(slot));
+		slot = read();
+	}
+	const double ns = BenchCase::getNsPerOp(start, qty);
+	allocs = BenchAlloc::getQty() - allocStart;
+	*c.log().info() << name << ": " << qty << " reads of " << BENCH_SERIAL_RECEIVED_SIZE << " B"
+			<< ", ns/read: " << std::fixed << std::setprecision(1) << ns
+			<< ", allocations/read: " << std::setprecision(4) << (qty ? static_cast<double>(allocs) / qty : 0);
+	return ns;
+}
+
+void benchSerial(BenchCase& c) {
+	uint8_t received[BENCH_SERIAL_RECEIVED_SIZE];
+	for (std::size_t i = 0; i < sizeof(received); i++) {
+		received[i] = static_cast<uint8_t>(i);
+	}
+	// the replaced reader copied the received bytes to a new vector
+	uint64_t allocs = 0;
+	double copy = 0;
+	{
+		std::vector<uint8_t> bufferRead(BENCH_SERIAL_READ_SIZE);
+		copy = runReads(c, "copy",
+			[&bufferRead, &received] () {
+				std::memcpy(bufferRead.data(), received, sizeof(received));
+				return BenchSerialBuffer(new std::vector<uint8_t>(bufferRead.begin(),
+						bufferRead.begin() + sizeof(received)));
+			},
+			[] (BenchSerialBuffer) {},
+			allocs
+		);
+	}
+	// the reader receives straight into the pooled buffer
+	{
+		Utils::BufferPool readPool(BENCH_SERIAL_READ_SIZE, BENCH_SERIAL_POOL_SIZE);
+		const double pool = runReads(c, "pool",
+			[&readPool, &received] () {
+				BenchSerialBuffer res = readPool.get();
+				res->resize(BENCH_SERIAL_READ_SIZE);
+				std::memcpy(res->data(), received, sizeof(received));
+				res->resize(sizeof(received));
+				return res;
+			},
+			[&readPool] (BenchSerialBuffer a) {
+				readPool.put(std::move(a));
+			},
+			allocs
+		);
+		c.check(!allocs, "pool: steady state reads don't allocate");
+		*c.log().info() << "pool/copy time per read: " << std::fixed << std::setprecision(2)
+				<< (copy ? pool / copy : 0);
+	}
+	// the port address of every data unit
+	{
+		const uint64_t qty = c.getConfig().qty;
+		const Networking::AddressSerial* port = Networking::AddressSerial::intern(
+				Networking::AddressSerialValT("/dev/serial/by-id/usb-FTDI_FT231X_USB_UART-if00-port0"));
+		uint64_t equal = 0;
+		const uint64_t allocStart = BenchAlloc::getQty();
+		for (uint64_t i = 0; i < qty; i++) {
+			const Networking::AddressSerialValT value(port->get());
+			if (value == port->get()) {
+				equal++;
+			}
+		}
+		const uint64_t allocs = BenchAlloc::getQty() - allocStart;
+		*c.log().info() << "address: " << qty << " copies of the port name value, allocations/copy: "
+				<< std::fixed << std::setprecision(4) << (qty ? static_cast<double>(allocs) / qty : 0);
+		c.check(equal == qty && !allocs, "address: copying the port name value doesn't allocate");
+	}
+}
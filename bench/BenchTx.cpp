@@ -0,0 +1,173 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Benchmark. Transmit flow control of the XBee network.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "BenchCase.h"
+#include "BenchAlloc.h"
+#include "XBeeNetTx.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <iomanip>
+
+#define BENCH_TX_ADDR_A						((XBeeFrameAddr64::type) 0x0013A20040A1B2C3ULL)
+#define BENCH_TX_ADDR_B						((XBeeFrameAddr64::type) 0x0013A20040D4E5F6ULL)
+#define BENCH_TX_ADDR16						((XBeeFrameAddr16::type) 0x1234)
+#define BENCH_TX_FAILED						((XBeeFrameDeliveryStatus::type) XBeeFrameDeliveryStatus::ROUTE_NOT_FOUND)
+#define BENCH_TX_PAYLOAD_SIZE				32
+#define BENCH_TX_TIMEOUT_MS					1
+
+
+/**
+ * Records what the flow control asks the XBee network to do
+ */
+struct BenchTxLink {
+	struct Frame {
+		XBeeFrameId::type							frameId;
+		XBeeFrameAddr64::type						addr64;
+	};
+	std::vector<Frame>								sent;
+	std::unordered_map<XBeeFrameAddr64::type, uint32_t>	resets;
+	XBeeNetTx										tx;
+
+	BenchTxLink(uint32_t retries, uint32_t timeoutMs)
+	:
+		tx(
+			[this] (XBeeFrameId::type frameId, XBeeFrameAddr64::type addr64, const Networking::Buffer&) {
+				sent.push_back({frameId, addr64});
+			},
+			[] (XBeeFrameAddr64::type, XBeeFrameAddr16::type, XBeeFrameDeliveryStatus::type) {},
+			[] (XBeeFrameAddr64::type, bool) {},
+			[this] (XBeeFrameAddr64::type addr64) {
+				resets[addr64]++;
+			}
+		)
+	{
+		sent.reserve(16);
+		tx.configure({2, retries, 32, timeoutMs});
+	}
+
+	void send(XBeeFrameAddr64::type addr64, uint32_t qty) {
+		for (uint32_t i = 0; i < qty; i++) {
+			tx.send(addr64, std::unique_ptr<Networking::Buffer>(new Networking::Buffer(BENCH_TX_PAYLOAD_SIZE)));
+		}
+	}
+
+	uint32_t getSent(XBeeFrameAddr64::type addr64) const {
+		uint32_t res = 0;
+		for (const Frame& i: sent) {
+			res += (i.addr64 == addr64);
+		}
+		return res;
+	}
+
+	uint32_t getResets(XBeeFrameAddr64::type addr64) const {
+		std::unordered_map<XBeeFrameAddr64::type, uint32_t>::const_iterator i = resets.find(addr64);
+		return i == resets.end() ? 0 : i->second;
+	}
+};
+
+/**
+ * Window of 2 => device A has 2 frames in flight and 2 queued, device B has 1 in flight.
+ * Every loss of the frame of A must reset the session of A only.
+ */
+static void runLoss(BenchCase& c, const std::string& name, uint32_t retries,
+		void (*lose)(BenchTxLink&, XBeeFrameId::type))
+{
+	BenchTxLink link(retries, 0);
+	link.send(BENCH_TX_ADDR_A, 4);
+	link.send(BENCH_TX_ADDR_B, 1);
+	const XBeeFrameId::type first = link.sent[0].frameId;
+	const XBeeFrameId::type second = link.sent[1].frameId;
+	const XBeeFrameId::type other = link.sent[2].frameId;
+	lose(link, first);
+	c.check(link.getResets(BENCH_TX_ADDR_A) == 1 && !link.getResets(BENCH_TX_ADDR_B),
+			name + ": the session of the device is reset");
+	c.check(link.getSent(BENCH_TX_ADDR_A) == 2 + retries,
+			name + ": no slice of the device is sent after the gap");
+	// the frames in flight of the device are dropped => the late TX Status is unknown
+	link.tx.onStatus(second, BENCH_TX_ADDR16, XBeeFrameDeliveryStatus::SUCCESS);
+	link.send(BENCH_TX_ADDR_A, 1);
+	c.check(link.getSent(BENCH_TX_ADDR_A) == 3 + retries,
+			name + ": the new session of the device is sent");
+	link.tx.onStatus(other, BENCH_TX_ADDR16, XBeeFrameDeliveryStatus::SUCCESS);
+	link.send(BENCH_TX_ADDR_B, 1);
+	c.check(link.getSent(BENCH_TX_ADDR_B) == 2 && !link.getResets(BENCH_TX_ADDR_B),
+			name + ": the other device is not affected");
+}
+
+void benchTx(BenchCase& c) {
+	// frames are lost for good
+	runLoss(c, "failed", 0,
+		[] (BenchTxLink& link, XBeeFrameId::type frameId) {
+			link.tx.onStatus(frameId, BENCH_TX_ADDR16, BENCH_TX_FAILED);
+		}
+	);
+	runLoss(c, "retried", 1,
+		[] (BenchTxLink& link, XBeeFrameId::type frameId) {
+			link.tx.onStatus(frameId, BENCH_TX_ADDR16, BENCH_TX_FAILED);
+			// re-sent once, the session is kept
+			if (!link.getResets(BENCH_TX_ADDR_A)) {
+				link.tx.onStatus(link.sent.back().frameId, BENCH_TX_ADDR16, BENCH_TX_FAILED);
+			}
+		}
+	);
+	// the module is restarted => the frames in flight of both devices are lost
+	{
+		BenchTxLink link(0, 0);
+		link.send(BENCH_TX_ADDR_A, 4);
+		link.send(BENCH_TX_ADDR_B, 1);
+		link.tx.onReset();
+		c.check(link.getResets(BENCH_TX_ADDR_A) == 1 && link.getResets(BENCH_TX_ADDR_B) == 1,
+				"reset: the sessions of the devices with frames in flight are reset");
+		c.check(link.getSent(BENCH_TX_ADDR_A) == 2, "reset: no slice of the device is sent after the gap");
+	}
+	// the TX Status is lost
+	{
+		BenchTxLink link(0, BENCH_TX_TIMEOUT_MS);
+		link.send(BENCH_TX_ADDR_A, 4);
+		std::this_thread::sleep_for(std::chrono::milliseconds(2 * BENCH_TX_TIMEOUT_MS));
+		link.tx.expire();
+		c.check(link.getResets(BENCH_TX_ADDR_A) == 1 && link.getSent(BENCH_TX_ADDR_A) == 2,
+				"timeout: the session of the device is reset, no slice is sent after the gap");
+	}
+	// steady state: every frame is confirmed
+	{
+		const uint64_t qty = c.getConfig().qty;
+		BenchTxLink link(0, 0);
+		std::vector<std::unique_ptr<Networking::Buffer> > data;
+		data.reserve(qty);
+		for (uint64_t i = 0; i < qty; i++) {
+			data.push_back(std::unique_ptr<Networking::Buffer>(new Networking::Buffer(BENCH_TX_PAYLOAD_SIZE)));
+		}
+		link.send(BENCH_TX_ADDR_A, 1);
+		link.tx.onStatus(link.sent.back().frameId, BENCH_TX_ADDR16, XBeeFrameDeliveryStatus::SUCCESS);
+		link.sent.clear();
+		const uint64_t allocStart = BenchAlloc::getQty();
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < qty; i++) {
+			link.tx.send(BENCH_TX_ADDR_A, std::move(data[i]));
+			link.tx.onStatus(link.sent.back().frameId, BENCH_TX_ADDR16, XBeeFrameDeliveryStatus::SUCCESS);
+			link.sent.clear();
+		}
+		const double ns = BenchCase::getNsPerOp(start, qty);
+		const uint64_t allocs = BenchAlloc::getQty() - allocStart;
+		*c.log().info() << "confirmed: " << qty << " frames, ns/frame: " << std::fixed << std::setprecision(1) << ns
+				<< ", allocations/frame: " << std::setprecision(4) << (qty ? static_cast<double>(allocs) / qty : 0);
+		c.check(!link.getResets(BENCH_TX_ADDR_A), "confirmed: no session is reset");
+	}
+}
@@ -0,0 +1,180 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Simulator. TCP sink acting as the MQTT broker.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "SimBroker.h"
+#include "SimMqtt.h"
+/* External Includes */
+/* System Includes */
+#include <deque>
+
+#define SIM_BROKER_READ_SIZE		4096
+
+///////////////////// SimBroker::Connection /////////////////////
+class SimBroker::Connection: public std::enable_shared_from_this<SimBroker::Connection> {
+public:
+	Connection(boost::asio::io_service& io, const SimBroker::Config& config, SimStats& stats)
+	:
+		mLog("SimBrokerConnection"),
+		mConfig(config),
+		mStats(stats),
+		mSocket(io),
+		mIsWriting(false)
+	{}
+
+	boost::asio::ip::tcp::socket& getSocket() { return mSocket; }
+
+	void start() {
+		boost::system::error_code ec;
+		mSocket.set_option(boost::asio::ip::tcp::no_delay(true), ec);
+		scheduleRead();
+	}
+private:
+	// Objects
+	Utils::Logger									mLog;
+	const SimBroker::Config&						mConfig;
+	SimStats&										mStats;
+	boost::asio::ip::tcp::socket					mSocket;
+	uint8_t											mBufferRead[SIM_BROKER_READ_SIZE];
+	SimMqtt::Buffer									mStream;
+	std::deque<SimMqtt::Buffer>						mWriteQueue;
+	bool											mIsWriting;
+
+	void scheduleRead() {
+		std::shared_ptr<Connection> self(shared_from_this());
+		mSocket.async_read_some(boost::asio::buffer(mBufferRead, sizeof(mBufferRead)),
+			[self, this] (const boost::system::error_code& error, std::size_t qty) {
+				onRead(error, qty);
+			}
+		);
+	}
+
+	void onRead(const boost::system::error_code& error, std::size_t qty) {
+		if (qty) {
+			mStream.insert(mStream.end(), mBufferRead, mBufferRead + qty);
+			std::size_t offset = 0;
+			std::size_t packetSize = 0;
+			while (offset < mStream.size()
+				&& SimMqtt::getPacketSize(mStream.data() + offset, mStream.size() - offset, packetSize)
+				&& packetSize <= mStream.size() - offset)
+			{
+				onPacket(mStream.data() + offset, packetSize);
+				offset += packetSize;
+			}
+			mStream.erase(mStream.begin(), mStream.begin() + offset);
+		}
+		if (error) {
+			*mLog.debug() << UTILS_STR_FUNCTION << ", closed: " << error.message();
+			return;
+		}
+		scheduleRead();
+	}
+
+	void onPacket(const uint8_t* packet, std::size_t size) {
+		switch (SimMqtt::Type::get(packet[0])) {
+			case SimMqtt::Type::CONNECT:
+				mStats.connects++;
+				write(SimMqtt::makeConnack());
+				break;
+			case SimMqtt::Type::PINGREQ:
+				write(SimMqtt::makePingresp());
+				break;
+			case SimMqtt::Type::PUBLISH:
+			{
+				mStats.published++;
+				const uint8_t* payload = nullptr;
+				std::size_t payloadSize = 0;
+				uint64_t time = 0;
+				if (SimMqtt::getPublishPayload(packet, size, payload, payloadSize)
+					&& SimMqtt::getTimestamp(payload, payloadSize, time))
+				{
+					mStats.uplink.add(SimStats::now() - time);
+				}
+				if (mConfig.isEcho) {
+					write(SimMqtt::Buffer(packet, packet + size));
+				}
+			}
+				break;
+			case SimMqtt::Type::DISCONNECT:
+				mSocket.close();
+				break;
+			default:
+				break;
+		}
+	}
+
+	void write(SimMqtt::Buffer data) {
+		mWriteQueue.push_back(std::move(data));
+		if (!mIsWriting) {
+			scheduleWrite();
+		}
+	}
+
+	void scheduleWrite() {
+		mIsWriting = true;
+		std::shared_ptr<Connection> self(shared_from_this());
+		boost::asio::async_write(mSocket, boost::asio::buffer(mWriteQueue.front()),
+			[self, this] (const boost::system::error_code& error, std::size_t) {
+				mWriteQueue.pop_front();
+				mIsWriting = false;
+				if (!error && !mWriteQueue.empty()) {
+					scheduleWrite();
+				}
+			}
+		);
+	}
+};
+
+///////////////////// SimBroker /////////////////////
+SimBroker::SimBroker(boost::asio::io_service& io, const Config& config, SimStats& stats)
+throw (Utils::Error)
+:
+	mLog(__FUNCTION__),
+	mIo(io),
+	mConfig(config),
+	mStats(stats),
+	mAcceptor(io)
+{
+	try {
+		const boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::tcp::v4(), mConfig.port);
+		mAcceptor.open(endpoint.protocol());
+		mAcceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+		mAcceptor.bind(endpoint);
+		mAcceptor.listen();
+	} catch (boost::system::system_error& e) {
+		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(SimBroker));
+	}
+}
+
+void SimBroker::start() {
+	*mLog.info() << "Listening on port: " << mConfig.port << ", echo: " << mConfig.isEcho;
+	scheduleAccept();
+}
+
+void SimBroker::scheduleAccept() {
+	std::shared_ptr<Connection> connection(new Connection(mIo, mConfig, mStats));
+	mAcceptor.async_accept(connection->getSocket(),
+		[this, connection] (const boost::system::error_code& error) {
+			onAccept(connection, error);
+		}
+	);
+}
+
+void SimBroker::onAccept(std::shared_ptr<Connection> connection, const boost::system::error_code& error) {
+	if (error) {
+		*mLog.error() << UTILS_STR_FUNCTION << ", error: " << error.message();
+		return;
+	}
+	connection->start();
+	scheduleAccept();
+}
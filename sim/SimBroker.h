@@ -0,0 +1,64 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Simulator. TCP sink acting as the MQTT broker.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef SIM_BROKER_H_
+#define SIM_BROKER_H_
+
+/* Internal Includes */
+#include "SimStats.h"
+#include "Error.h"
+#include "Logger.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <memory>
+#include <boost/asio.hpp>
+
+
+/**
+ * Accepts the gateway connections and answers the simulated sessions:
+ * CONNECT => CONNACK, PINGREQ => PINGRESP.
+ * PUBLISH is counted and optionally echoed back to exercise the downlink.
+ */
+class SimBroker {
+public:
+	struct Config {
+		uint32_t									port;
+		bool										isEcho;
+	};
+
+	SimBroker(boost::asio::io_service& io, const Config& config, SimStats& stats) throw (Utils::Error);
+
+	/**
+	 * Starts accepting connections
+	 */
+	void start();
+private:
+	class Connection;
+
+	// Objects
+	Utils::Logger									mLog;
+	boost::asio::io_service&						mIo;
+	const Config									mConfig;
+	SimStats&										mStats;
+	boost::asio::ip::tcp::acceptor					mAcceptor;
+
+	// Do not copy
+	SimBroker(const SimBroker&);
+	SimBroker &operator=(const SimBroker&);
+
+	void scheduleAccept();
+	void onAccept(std::shared_ptr<Connection>, const boost::system::error_code&);
+};
+
+#endif /* SIM_BROKER_H_ */
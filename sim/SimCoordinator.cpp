@@ -0,0 +1,380 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Simulator. XBee coordinator emulated on a pseudo-terminal.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "SimCoordinator.h"
+#include "SimMqtt.h"
+#include "XBeeFrameSchema.h"
+/* External Includes */
+/* System Includes */
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#define SIM_COORDINATOR_ADDR64_BASE			0x0013A20000000000ULL
+#define SIM_COORDINATOR_ADDR16_BASE			0x1000
+#define SIM_COORDINATOR_CONNECT_PERIOD_US	5000000
+#define SIM_COORDINATOR_KEEP_ALIVE_SEC		60
+
+///////////////////// SimCoordinator::Device /////////////////////
+struct SimCoordinator::Device {
+	const uint32_t									index;
+	const XBeeFrameAddr64::type						addr64;
+	const XBeeFrameAddr16::type						addr16;
+	const std::string								clientId;
+	const std::string								topic;
+	boost::asio::deadline_timer						timer;
+	bool											isConnected;
+	SimMqtt::Buffer									stream;			// downlink MQTT stream
+
+	Device(boost::asio::io_service& io, uint32_t i)
+	:
+		index(i),
+		addr64(SIM_COORDINATOR_ADDR64_BASE + i + 1),
+		addr16(SIM_COORDINATOR_ADDR16_BASE + i),
+		clientId("sim-" + std::to_string(i)),
+		topic("sim/" + std::to_string(i)),
+		timer(io),
+		isConnected(false)
+	{}
+};
+
+///////////////////// SimCoordinator /////////////////////
+SimCoordinator::SimCoordinator(boost::asio::io_service& io, const Config& config, SimStats& stats)
+throw (Utils::Error)
+:
+	mLog(__FUNCTION__),
+	mIo(io),
+	mConfig(config),
+	mStats(stats),
+	mMaster(io),
+	mSlave(-1),
+	mBaudCode(6),
+	mIsEscapeSequence(false),
+	mIsWriting(false)
+{
+	const int master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0) {
+		throw Utils::Error(std::string("posix_openpt: ") + strerror(errno));
+	}
+	if (grantpt(master) || unlockpt(master) || !ptsname(master)) {
+		const std::string msg = std::string("pseudo-terminal setup: ") + strerror(errno);
+		close(master);
+		throw Utils::Error(msg);
+	}
+	mSlaveName = ptsname(master);
+	mSlave = open(mSlaveName.c_str(), O_RDWR | O_NOCTTY);
+	if (mSlave < 0) {
+		const std::string msg = "open " + mSlaveName + ": " + strerror(errno);
+		close(master);
+		throw Utils::Error(msg);
+	}
+	// binary data => no line discipline processing
+	struct termios tio;
+	if (tcgetattr(mSlave, &tio) == 0) {
+		cfmakeraw(&tio);
+		tcsetattr(mSlave, TCSANOW, &tio);
+	}
+	mMaster.assign(master);
+	if (!mConfig.link.empty()) {
+		struct stat st;
+		if (lstat(mConfig.link.c_str(), &st) == 0 && S_ISLNK(st.st_mode)) {
+			unlink(mConfig.link.c_str());
+		}
+		if (symlink(mSlaveName.c_str(), mConfig.link.c_str())) {
+			const std::string msg = "symlink " + mConfig.link + ": " + strerror(errno);
+			close(mSlave);
+			throw Utils::Error(msg);
+		}
+	}
+	for (uint32_t i = 0; i < mConfig.devices; i++) {
+		mDevices.emplace_back(new Device(mIo, i));
+		mDevicesByAddr[mDevices.back()->addr64] = mDevices.back().get();
+	}
+}
+
+SimCoordinator::~SimCoordinator() {
+	if (!mConfig.link.empty()) {
+		unlink(mConfig.link.c_str());
+	}
+	if (mSlave >= 0) {
+		close(mSlave);
+	}
+}
+
+void SimCoordinator::start() {
+	*mLog.info() << "Serial: " << mSlaveName
+			<< (mConfig.link.empty() ? "" : " <= " + mConfig.link)
+			<< ", api-mode: " << mConfig.apiMode
+			<< ", devices: " << mConfig.devices
+			<< ", rate: " << mConfig.rate
+			<< ", payload: " << mConfig.payloadSize
+			<< ", mtu: " << mConfig.mtu;
+	scheduleRead();
+	// spread the sessions over the first second
+	for (auto& d: mDevices) {
+		scheduleSession(*d, 1000000ULL * d->index / mDevices.size());
+	}
+}
+
+void SimCoordinator::scheduleRead() {
+	mMaster.async_read_some(boost::asio::buffer(mBufferRead, sizeof(mBufferRead)),
+		[this] (const boost::system::error_code& error, std::size_t qty) {
+			onRead(error, qty);
+		}
+	);
+}
+
+void SimCoordinator::onRead(const boost::system::error_code& error, std::size_t qty) {
+	for (std::size_t i = 0; i < qty; i++) {
+		onByte(mBufferRead[i]);
+	}
+	if (error) {
+		*mLog.error() << UTILS_STR_FUNCTION << ", error: " << error.message();
+		return;
+	}
+	scheduleRead();
+}
+
+void SimCoordinator::onByte(uint8_t b) {
+	if (b == XBeeFrameDelimiter::VALUE
+		&& (mConfig.apiMode == XBeeFrameApiMode::ESCAPED || mFrame.empty()))
+	{
+		// API mode 2 => the delimiter is never a data => resync
+		if (!mFrame.empty()) {
+			mStats.badFrames++;
+		}
+		mFrame.clear();
+		mFrame.push_back(b);
+		mIsEscapeSequence = false;
+		return;
+	}
+	if (mFrame.empty()) {
+		// garbage before the delimiter
+		return;
+	}
+	if (mConfig.apiMode == XBeeFrameApiMode::ESCAPED) {
+		if (b == XBeeFrameEscape::ESCAPE) {
+			mIsEscapeSequence = true;
+			return;
+		}
+		if (mIsEscapeSequence) {
+			b = XBeeFrameEscape::apply(b);
+			mIsEscapeSequence = false;
+		}
+	}
+	mFrame.push_back(b);
+	if (mFrame.size() >= XBEE_FRAME_HEADER_SIZE) {
+		const std::size_t size = XBEE_FRAME_HEADER_SIZE
+				+ XBeeFrameSchema::Length::decode(mFrame.data() + 1) + XBEE_FRAME_CHECKSUM_SIZE;
+		if (mFrame.size() >= size) {
+			onFrame();
+			mFrame.clear();
+		}
+	}
+}
+
+void SimCoordinator::onFrame() {
+	if (!XBeeFrameChecksum::isValid(mFrame.data() + XBEE_FRAME_HEADER_SIZE,
+			mFrame.size() - XBEE_FRAME_HEADER_SIZE))
+	{
+		mStats.badFrames++;
+		return;
+	}
+	XBeeFrameView view;
+	const XBeeFrameStatus::Type status = view.decode(mFrame);
+	if (status != XBeeFrameStatus::OK) {
+		*mLog.warn() << UTILS_STR_FUNCTION << ", " << XBeeFrameStatus::toString(status);
+		mStats.badFrames++;
+		return;
+	}
+	switch (view.getApiId()) {
+		case XBeeFrameApiId::ZB_TX_REQ:
+			onTxReq(view);
+			break;
+		case XBeeFrameApiId::AT_CMD:
+			onAtCmd(view);
+			break;
+		default:
+			*mLog.warn() << UTILS_STR_FUNCTION << ", unexpected API Id: " << view.getApiId();
+			break;
+	}
+}
+
+void SimCoordinator::onTxReq(const XBeeFrameView& view) {
+	mStats.txFrames++;
+	mStats.txBytes += view.getDataSize();
+	typedef XBeeFrameSchema::ZbTxReq F;
+	const XBeeFrameId::type frameId = view.get<F, XBeeFrameSchema::FrameId>();
+	const auto it = mDevicesByAddr.find(view.get<F, XBeeFrameSchema::Addr64>());
+	Device* device = (it == mDevicesByAddr.end()) ? nullptr : it->second;
+	if (frameId != XBeeFrameId::NO_RSP) {
+		XBeeBuffer rsp;
+		XBeeFrameSchema::ZbTxStatus::encode(mConfig.apiMode, rsp, frameId,
+				device ? device->addr16 : XBeeFrameAddr16::UNKNOWN,
+				0,
+				device ? XBeeFrameDeliveryStatus::SUCCESS : XBeeFrameDeliveryStatus::ADDRESS_NOT_FOUND,
+				0,
+				nullptr, 0);
+		write(std::move(rsp));
+	}
+	if (device) {
+		onDownlink(*device, view.getData(), view.getDataSize());
+	}
+}
+
+void SimCoordinator::onAtCmd(const XBeeFrameView& view) {
+	typedef XBeeFrameSchema::AtCmd F;
+	const XBeeFrameId::type frameId = view.get<F, XBeeFrameSchema::FrameId>();
+	const XBeeFrameAtCommand::type command = view.get<F, XBeeFrameSchema::AtCommand>();
+	uint8_t data[2];
+	std::size_t size = 0;
+	if (command == XBeeFrameAtCommand::NP) {
+		data[0] = static_cast<uint8_t>(mConfig.mtu >> 8);
+		data[1] = static_cast<uint8_t>(mConfig.mtu);
+		size = sizeof(data);
+	} else if (command == XBeeFrameAtCommand::BD) {
+		// the pseudo-terminal has no rate => only the value is kept
+		if (view.getDataSize()) {
+			mBaudCode = view.getData()[view.getDataSize() - 1];
+		} else {
+			data[0] = mBaudCode;
+			size = 1;
+		}
+	}
+	if (frameId != XBeeFrameId::NO_RSP) {
+		XBeeBuffer rsp;
+		XBeeFrameSchema::AtCmdRsp::encode(mConfig.apiMode, rsp, frameId, command,
+				XBeeFrameAtStatus::OK, data, size);
+		write(std::move(rsp));
+	}
+}
+
+void SimCoordinator::onDownlink(Device& device, const uint8_t* data, std::size_t size) {
+	SimMqtt::Buffer& s = device.stream;
+	s.insert(s.end(), data, data + size);
+	std::size_t offset = 0;
+	std::size_t packetSize = 0;
+	while (offset < s.size()
+		&& SimMqtt::getPacketSize(s.data() + offset, s.size() - offset, packetSize)
+		&& packetSize <= s.size() - offset)
+	{
+		const uint8_t* packet = s.data() + offset;
+		switch (SimMqtt::Type::get(packet[0])) {
+			case SimMqtt::Type::CONNACK:
+				mStats.connacks++;
+				if (!device.isConnected) {
+					device.isConnected = true;
+					// start publishing without waiting the CONNECT period
+					scheduleSession(device, 0);
+				}
+				break;
+			case SimMqtt::Type::PUBLISH:
+			{
+				mStats.echoed++;
+				const uint8_t* payload = nullptr;
+				std::size_t payloadSize = 0;
+				uint64_t time = 0;
+				if (SimMqtt::getPublishPayload(packet, packetSize, payload, payloadSize)
+					&& SimMqtt::getTimestamp(payload, payloadSize, time))
+				{
+					mStats.roundTrip.add(SimStats::now() - time);
+				}
+			}
+				break;
+			default:
+				break;
+		}
+		offset += packetSize;
+	}
+	s.erase(s.begin(), s.begin() + offset);
+}
+
+void SimCoordinator::scheduleSession(Device& device, uint64_t delayUs) {
+	// re-arming cancels the pending wait
+	device.timer.expires_from_now(boost::posix_time::microseconds(delayUs));
+	device.timer.async_wait(
+		[this, &device] (const boost::system::error_code& error) {
+			if (!error) {
+				onSession(device);
+			}
+		}
+	);
+}
+
+void SimCoordinator::onSession(Device& device) {
+	if (!device.isConnected) {
+		sendUplink(device, SimMqtt::makeConnect(device.clientId, SIM_COORDINATOR_KEEP_ALIVE_SEC));
+		scheduleSession(device, SIM_COORDINATOR_CONNECT_PERIOD_US);
+		return;
+	}
+	if (mConfig.rate <= 0) {
+		// connect only
+		return;
+	}
+	SimMqtt::Buffer payload;
+	SimMqtt::putTimestamp(payload, SimStats::now());
+	if (payload.size() < mConfig.payloadSize) {
+		payload.resize(mConfig.payloadSize, static_cast<uint8_t>('a' + device.index % 26));
+	}
+	sendUplink(device, SimMqtt::makePublish(device.topic, payload));
+	scheduleSession(device, static_cast<uint64_t>(1000000 / mConfig.rate));
+}
+
+void SimCoordinator::sendUplink(Device& device, const std::vector<uint8_t>& data) {
+	const std::size_t mtu = mConfig.mtu ? mConfig.mtu : data.size();
+	const std::size_t qty = (data.size() + mtu - 1) / mtu;
+	if (mWriteQueue.size() + qty > mConfig.queueSize) {
+		// the whole message => the MQTT stream stays consistent
+		mStats.rxDrops += qty;
+		return;
+	}
+	for (std::size_t offset = 0; offset < data.size(); offset += mtu) {
+		const std::size_t size = std::min(mtu, data.size() - offset);
+		XBeeBuffer frame;
+		XBeeFrameSchema::ZbRxRsp::encode(mConfig.apiMode, frame, device.addr64, device.addr16,
+				XBeeFrameOptionsRecv::PKT_ACKED, data.data() + offset, size);
+		mStats.rxFrames++;
+		mStats.rxBytes += size;
+		write(std::move(frame));
+	}
+}
+
+void SimCoordinator::write(XBeeBuffer frame) {
+	mWriteQueue.push_back(std::move(frame));
+	if (!mIsWriting) {
+		scheduleWrite();
+	}
+}
+
+void SimCoordinator::scheduleWrite() {
+	mIsWriting = true;
+	boost::asio::async_write(mMaster, boost::asio::buffer(mWriteQueue.front()),
+		[this] (const boost::system::error_code& error, std::size_t) {
+			mWriteQueue.pop_front();
+			mIsWriting = false;
+			if (error) {
+				*mLog.error() << UTILS_STR_FUNCTION << ", error: " << error.message();
+				return;
+			}
+			if (!mWriteQueue.empty()) {
+				scheduleWrite();
+			}
+		}
+	);
+}
@@ -0,0 +1,109 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Simulator. XBee coordinator emulated on a pseudo-terminal.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef SIM_COORDINATOR_H_
+#define SIM_COORDINATOR_H_
+
+/* Internal Includes */
+#include "SimStats.h"
+#include "XBeeFrame.h"
+#include "Error.h"
+#include "Logger.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <boost/asio.hpp>
+
+
+/**
+ * Emulates the coordinator with attached devices.
+ *
+ * The gateway opens the slave side of the pseudo-terminal as a serial port.
+ * Every device runs a scripted MQTT session: CONNECT till CONNACK, then
+ * QoS 0 PUBLISH with a time stamp at the configured rate. The ZB_TX_REQ
+ * frames are answered with a successful TX Status and the downlink stream
+ * of every device is parsed to detect CONNACK and echoed PUBLISH.
+ */
+class SimCoordinator {
+public:
+	struct Config {
+		std::string									link;			// symbolic link to the slave
+		XBeeFrameApiMode::Type						apiMode;
+		uint32_t									devices;
+		double										rate;			// PUBLISH per second per device
+		uint32_t									payloadSize;
+		uint32_t									mtu;			// reported by NP; uplink frames are split by it
+		uint32_t									queueSize;		// frames waiting the gateway; uplink is dropped above
+	};
+
+	SimCoordinator(boost::asio::io_service& io, const Config& config, SimStats& stats) throw (Utils::Error);
+	~SimCoordinator();
+
+	/**
+	 * Starts the device sessions
+	 */
+	void start();
+
+	/**
+	 * Gets the slave side name
+	 */
+	const std::string& getSlaveName() const { return mSlaveName; }
+private:
+	struct Device;
+
+	// Objects
+	Utils::Logger									mLog;
+	boost::asio::io_service&						mIo;
+	const Config									mConfig;
+	SimStats&										mStats;
+	boost::asio::posix::stream_descriptor			mMaster;
+	// keeps the slave open => no EIO on the master while the gateway is closed
+	int												mSlave;
+	std::string										mSlaveName;
+	// BD parameter
+	uint8_t											mBaudCode;
+	std::vector<std::unique_ptr<Device> >			mDevices;
+	std::unordered_map<XBeeFrameAddr64::type, Device*>	mDevicesByAddr;
+	// reading
+	uint8_t											mBufferRead[1024];
+	XBeeBuffer										mFrame;
+	bool											mIsEscapeSequence;
+	// writing
+	std::deque<XBeeBuffer>							mWriteQueue;
+	bool											mIsWriting;
+
+	// Do not copy
+	SimCoordinator(const SimCoordinator&);
+	SimCoordinator &operator=(const SimCoordinator&);
+
+	// Methods
+	void scheduleRead();
+	void onRead(const boost::system::error_code&, std::size_t);
+	void onByte(uint8_t);
+	void onFrame();
+	void onTxReq(const XBeeFrameView&);
+	void onAtCmd(const XBeeFrameView&);
+	void onDownlink(Device&, const uint8_t*, std::size_t);
+	void scheduleSession(Device&, uint64_t delayUs);
+	void onSession(Device&);
+	void sendUplink(Device&, const std::vector<uint8_t>&);
+	void write(XBeeBuffer);
+	void scheduleWrite();
+};
+
+#endif /* SIM_COORDINATOR_H_ */
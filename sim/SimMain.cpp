@@ -0,0 +1,216 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Simulator. Main function.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "SimCoordinator.h"
+#include "SimBroker.h"
+#include "SimStats.h"
+#include "Logger.h"
+#include "LogManager.h"
+#include "Configuration.h"
+#include "Error.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <iomanip>
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+
+#define SIM_MAIN_REPORT_PERIOD_SEC		1
+
+
+/**
+ * Periodic report of the counters.
+ * Rates are calculated over the report period.
+ */
+class SimReport {
+public:
+	SimReport(boost::asio::io_service& io, const SimStats& stats, uint32_t durationSec)
+	:
+		mLog("SimReport"),
+		mIo(io),
+		mStats(stats),
+		mTimer(io),
+		mDurationSec(durationSec),
+		mElapsedSec(0),
+		mLast(stats),
+		mFirst(stats),
+		mFirstSec(0)
+	{}
+
+	void start() {
+		schedule();
+	}
+
+	/**
+	 * Average uplink frames per second since the first published message
+	 */
+	double getRxFps() const {
+		const uint32_t sec = mElapsedSec - mFirstSec;
+		return sec ? static_cast<double>(mStats.rxFrames - mFirst.rxFrames) / sec : 0;
+	}
+
+	void dump() const {
+		*mLog.info() << "Total"
+				<< ", rx frames: " << mStats.rxFrames << " (" << mStats.rxBytes << " B)"
+				<< ", rx drops: " << mStats.rxDrops
+				<< ", tx frames: " << mStats.txFrames << " (" << mStats.txBytes << " B)"
+				<< ", bad frames: " << mStats.badFrames
+				<< ", connects: " << mStats.connects
+				<< ", connacks: " << mStats.connacks
+				<< ", published: " << mStats.published
+				<< ", echoed: " << mStats.echoed;
+		*mLog.info() << "Average rx fps: " << std::fixed << std::setprecision(1) << getRxFps()
+				<< ", uplink us avg/max: " << mStats.uplink.getAvgUs() << "/" << mStats.uplink.maxUs
+				<< ", round-trip us avg/max: " << mStats.roundTrip.getAvgUs() << "/" << mStats.roundTrip.maxUs;
+	}
+private:
+	// Objects
+	Utils::Logger									mLog;
+	boost::asio::io_service&						mIo;
+	const SimStats&									mStats;
+	boost::asio::deadline_timer						mTimer;
+	const uint32_t									mDurationSec;
+	uint32_t										mElapsedSec;
+	SimStats										mLast;
+	// the warm-up (CONNECT till CONNACK) is excluded from the average
+	SimStats										mFirst;
+	uint32_t										mFirstSec;
+
+	void schedule() {
+		mTimer.expires_from_now(boost::posix_time::seconds(SIM_MAIN_REPORT_PERIOD_SEC));
+		mTimer.async_wait(
+			[this] (const boost::system::error_code& error) {
+				if (!error) {
+					onTimer();
+				}
+			}
+		);
+	}
+
+	void onTimer() {
+		mElapsedSec += SIM_MAIN_REPORT_PERIOD_SEC;
+		*mLog.info() << "rx fps: " << (mStats.rxFrames - mLast.rxFrames) / SIM_MAIN_REPORT_PERIOD_SEC
+				<< ", tx fps: " << (mStats.txFrames - mLast.txFrames) / SIM_MAIN_REPORT_PERIOD_SEC
+				<< ", published/s: " << (mStats.published - mLast.published) / SIM_MAIN_REPORT_PERIOD_SEC
+				<< ", rx drops: " << mStats.rxDrops - mLast.rxDrops
+				<< ", connacks: " << mStats.connacks
+				<< ", uplink us avg: " << mStats.uplink.getAvgUs();
+		if (!mFirst.published && mStats.published) {
+			mFirst = mStats;
+			mFirstSec = mElapsedSec;
+		}
+		mLast = mStats;
+		if (mDurationSec && mElapsedSec >= mDurationSec) {
+			mIo.stop();
+			return;
+		}
+		schedule();
+	}
+};
+
+int main(int argc, char* argv[]) {
+	Utils::Logger log("SimMain");
+	int res = 0;
+	try {
+		SimCoordinator::Config coordinatorConfig;
+		SimBroker::Config brokerConfig;
+		uint32_t apiMode = 0;
+		uint32_t duration = 0;
+		double minFps = 0;
+		std::string logLevel;
+		boost::program_options::options_description desc("Simulator options");
+		desc.add_options()
+			("help,h", "Show help")
+			("link,l", boost::program_options::value<std::string>(&coordinatorConfig.link)->default_value(""),
+				"Symbolic link to the serial port, e.g. /tmp/xbee-sim")
+			("api-mode", boost::program_options::value<uint32_t>(&apiMode)->default_value(2), "XBee API mode: 1 or 2")
+			("devices,n", boost::program_options::value<uint32_t>(&coordinatorConfig.devices)->default_value(10),
+				"Number of simulated devices")
+			("rate,r", boost::program_options::value<double>(&coordinatorConfig.rate)->default_value(1),
+				"PUBLISH per second per device; 0 => connect only")
+			("payload", boost::program_options::value<uint32_t>(&coordinatorConfig.payloadSize)->default_value(32),
+				"PUBLISH payload size in bytes")
+			("mtu", boost::program_options::value<uint32_t>(&coordinatorConfig.mtu)->default_value(84),
+				"Maximum data bytes in one frame, reported by NP")
+			("queue-size", boost::program_options::value<uint32_t>(&coordinatorConfig.queueSize)->default_value(1024),
+				"Frames waiting the gateway; uplink is dropped above")
+			("port,p", boost::program_options::value<uint32_t>(&brokerConfig.port)->default_value(1883),
+				"Broker TCP port")
+			("echo", boost::program_options::value<bool>(&brokerConfig.isEcho)->default_value(true),
+				"Broker sends every PUBLISH back to the device")
+			("duration,d", boost::program_options::value<uint32_t>(&duration)->default_value(0),
+				"Run time in seconds; 0 => till interrupted")
+			("min-fps", boost::program_options::value<double>(&minFps)->default_value(0),
+				"Fail when the average rx frames per second is lower")
+			("log-level", boost::program_options::value<std::string>(&logLevel)->default_value("INFO"),
+				"ERROR, WARN, INFO, DEBUG or TRACE")
+		;
+		try {
+			boost::program_options::variables_map vm;
+			boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
+			if (vm.count("help")) {
+				*log.info() << desc;
+				throw Utils::Error(Utils::ErrorCode::OK, "help has been requested");
+			}
+			boost::program_options::notify(vm);
+			if (apiMode != XBeeFrameApiMode::UNESCAPED && apiMode != XBeeFrameApiMode::ESCAPED) {
+				throw Utils::Error("api-mode, wrong value [" + std::to_string(apiMode) + "]");
+			}
+			coordinatorConfig.apiMode = static_cast<XBeeFrameApiMode::Type>(apiMode);
+			Utils::Configuration::get().logger.level = Utils::LoggerLevel::fromString(logLevel);
+		} catch (Utils::Error& e) {
+			throw;
+		} catch (std::exception& e) {
+			*log.info() << desc;
+			throw Utils::Error(e, "Options");
+		}
+		Utils::LogManager::get().start();
+		boost::asio::io_service io;
+		SimStats stats;
+		SimBroker broker(io, brokerConfig, stats);
+		SimCoordinator coordinator(io, coordinatorConfig, stats);
+		SimReport report(io, stats, duration);
+		boost::asio::signal_set signals(io, SIGINT, SIGTERM);
+		signals.async_wait(
+			[&io] (const boost::system::error_code& error, int) {
+				if (!error) {
+					io.stop();
+				}
+			}
+		);
+		broker.start();
+		coordinator.start();
+		report.start();
+		io.run();
+		report.dump();
+		if (report.getRxFps() < minFps) {
+			*log.error() << "Average rx fps is lower than " << minFps;
+			res = 1;
+		}
+	} catch (Utils::Error& e) {
+		if (e.getCode() == Utils::ErrorCode::OK) {
+			*log.info() << e.what();
+		} else {
+			*log.error() << e.what();
+			res = 1;
+		}
+	} catch (std::exception& e) {
+		*log.error() << e.what();
+		res = 1;
+	}
+	// It was the last log => flush everything in logger
+	Utils::Configuration::destroy();
+	Utils::LogManager::destroy();
+	return res;
+}
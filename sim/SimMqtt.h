@@ -0,0 +1,168 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Simulator. Minimal MQTT packets used by the simulated sessions.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef SIM_MQTT_H_
+#define SIM_MQTT_H_
+
+/* Internal Includes */
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace SimMqtt {
+
+typedef std::vector<uint8_t> Buffer;
+
+struct Type {
+	enum type {
+		CONNECT		= 0x10,
+		CONNACK		= 0x20,
+		PUBLISH		= 0x30,
+		PINGREQ		= 0xC0,
+		PINGRESP	= 0xD0,
+		DISCONNECT	= 0xE0,
+	};
+	static uint8_t get(uint8_t header) { return header & 0xF0; }
+};
+
+/**
+ * Gets the packet size from the fixed header
+ *
+ * @return false if the fixed header is incomplete
+ */
+inline bool getPacketSize(const uint8_t* data, std::size_t size, std::size_t& packetSize) {
+	std::size_t remaining = 0;
+	std::size_t multiplier = 1;
+	for (std::size_t i = 1; i < size && i <= 4; i++) {
+		remaining += (data[i] & 0x7F) * multiplier;
+		if (!(data[i] & 0x80)) {
+			packetSize = 1 + i + remaining;
+			return true;
+		}
+		multiplier *= 128;
+	}
+	if (size > 5) {
+		// malformed => consume everything
+		packetSize = size;
+		return true;
+	}
+	return false;
+}
+
+inline void putHeader(Buffer& out, uint8_t header, std::size_t remaining) {
+	out.push_back(header);
+	do {
+		uint8_t b = remaining % 128;
+		remaining /= 128;
+		if (remaining) {
+			b |= 0x80;
+		}
+		out.push_back(b);
+	} while (remaining);
+}
+
+inline void putString(Buffer& out, const std::string& v) {
+	out.push_back(static_cast<uint8_t>(v.size() >> 8));
+	out.push_back(static_cast<uint8_t>(v.size()));
+	out.insert(out.end(), v.begin(), v.end());
+}
+
+/**
+ * MQTT 3.1.1 CONNECT with clean session
+ */
+inline Buffer makeConnect(const std::string& clientId, uint16_t keepAliveSec) {
+	Buffer res;
+	putHeader(res, Type::CONNECT, 10 + 2 + clientId.size());
+	putString(res, "MQTT");
+	res.push_back(4);								// protocol level
+	res.push_back(0x02);							// clean session
+	res.push_back(static_cast<uint8_t>(keepAliveSec >> 8));
+	res.push_back(static_cast<uint8_t>(keepAliveSec));
+	putString(res, clientId);
+	return res;
+}
+
+inline Buffer makeConnack() {
+	return Buffer({Type::CONNACK, 0x02, 0x00, 0x00});
+}
+
+inline Buffer makePingresp() {
+	return Buffer({Type::PINGRESP, 0x00});
+}
+
+/**
+ * QoS 0 PUBLISH
+ */
+inline Buffer makePublish(const std::string& topic, const Buffer& payload) {
+	Buffer res;
+	putHeader(res, Type::PUBLISH, 2 + topic.size() + payload.size());
+	putString(res, topic);
+	res.insert(res.end(), payload.begin(), payload.end());
+	return res;
+}
+
+/**
+ * Payload of the QoS 0 PUBLISH
+ *
+ * @return false if the packet is malformed
+ */
+inline bool getPublishPayload(const uint8_t* packet, std::size_t size, const uint8_t*& payload, std::size_t& payloadSize) {
+	std::size_t header = 1;
+	while (header < size && (packet[header] & 0x80)) {
+		header++;
+	}
+	header++;
+	if (header + 2 > size) {
+		return false;
+	}
+	const std::size_t topicSize = (static_cast<std::size_t>(packet[header]) << 8) | packet[header + 1];
+	std::size_t offset = header + 2 + topicSize;
+	if ((packet[0] & 0x06) != 0) {
+		// QoS > 0 => packet identifier
+		offset += 2;
+	}
+	if (offset > size) {
+		return false;
+	}
+	payload = packet + offset;
+	payloadSize = size - offset;
+	return true;
+}
+
+/**
+ * 64-bit big-endian time stamp at the payload start
+ */
+inline void putTimestamp(Buffer& payload, uint64_t v) {
+	for (int i = 7; i >= 0; i--) {
+		payload.push_back(static_cast<uint8_t>(v >> (8*i)));
+	}
+}
+
+inline bool getTimestamp(const uint8_t* payload, std::size_t size, uint64_t& v) {
+	if (size < 8) {
+		return false;
+	}
+	v = 0;
+	for (std::size_t i = 0; i < 8; i++) {
+		v = (v << 8) | payload[i];
+	}
+	return true;
+}
+
+} /* namespace SimMqtt */
+
+#endif /* SIM_MQTT_H_ */
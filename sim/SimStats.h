@@ -0,0 +1,80 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Simulator. Load statistics.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef SIM_STATS_H_
+#define SIM_STATS_H_
+
+/* Internal Includes */
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <chrono>
+
+
+/**
+ * Latency accumulator
+ */
+struct SimLatency {
+	uint64_t										qty;
+	uint64_t										sumUs;
+	uint64_t										maxUs;
+
+	SimLatency(): qty(0), sumUs(0), maxUs(0) {}
+
+	void add(uint64_t us) {
+		qty++;
+		sumUs += us;
+		if (us > maxUs) {
+			maxUs = us;
+		}
+	}
+
+	uint64_t getAvgUs() const { return qty ? sumUs / qty : 0; }
+};
+
+/**
+ * Counters of the simulated coordinator and broker.
+ * Everything runs on one I/O service thread => no locking.
+ */
+struct SimStats {
+	// serial side
+	uint64_t										rxFrames;		// ZB_RX_RSP frames written to the gateway
+	uint64_t										rxBytes;
+	uint64_t										rxDrops;		// frames dropped because the gateway doesn't read
+	uint64_t										txFrames;		// ZB_TX_REQ frames received from the gateway
+	uint64_t										txBytes;
+	uint64_t										badFrames;
+	// broker side
+	uint64_t										connects;
+	uint64_t										published;
+	// devices side
+	uint64_t										connacks;
+	uint64_t										echoed;
+	SimLatency										uplink;			// device -> broker
+	SimLatency										roundTrip;		// device -> broker -> device
+
+	SimStats():
+		rxFrames(0), rxBytes(0), rxDrops(0), txFrames(0), txBytes(0), badFrames(0),
+		connects(0), published(0), connacks(0), echoed(0)
+	{}
+
+	/**
+	 * Time stamp carried by the simulated messages
+	 */
+	static uint64_t now() {
+		return std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+};
+
+#endif /* SIM_STATS_H_ */
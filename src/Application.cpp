@@ -20,6 +20,7 @@
 #include "TcpNet.h"
 #include "Router.h"
 #include "Mqtt.h"
+#include "Configuration.h"
 /* External Includes */
 /* System Includes */
 
@@ -65,7 +66,6 @@ throw (Utils::Error)
 	mSem(0, 1),
 	mProcessor(nullptr),
 	mSignalProcessor(nullptr),
-	mSerial(nullptr),
 	mXBeeNet(nullptr),
 	mTcpNet(nullptr),
 	mRouter(nullptr),
@@ -73,7 +73,7 @@ throw (Utils::Error)
 {
 	std::unique_ptr<Utils::CommandProcessor> ptrProcessor;
 	std::unique_ptr<SignalProcessor> ptrSignalProcessor;
-	std::unique_ptr<SerialPort> ptrSerial;
+	std::vector<std::unique_ptr<SerialPort> > ptrSerials;
 	std::unique_ptr<XBeeNet> ptrXBeeNet;
 	std::unique_ptr<TcpNet> ptrTcpNet;
 	std::unique_ptr<Router> ptrRouter;
@@ -84,7 +84,9 @@ throw (Utils::Error)
 		*mLog.info() << "INITIALIZATION";
 		ptrProcessor.reset(new Utils::CommandProcessor(mLog.getName()));
 		ptrSignalProcessor.reset(new SignalProcessor());
-		ptrSerial.reset(new SerialPort());
+		for (std::size_t i = 0; i < Utils::Configuration::get().serial.ports.size(); i++) {
+			ptrSerials.emplace_back(new SerialPort(i));
+		}
 		ptrXBeeNet.reset(new XBeeNet());
 		ptrTcpNet.reset(new TcpNet());
 		ptrRouter.reset(new Router());
@@ -96,7 +98,10 @@ throw (Utils::Error)
 	// no exceptions from this point => destructor will control deallocations
 	mProcessor = ptrProcessor.release();
 	mSignalProcessor = ptrSignalProcessor.release();
-	mSerial = ptrSerial.release();
+	mSerials.reserve(ptrSerials.size());
+	for (auto& i: ptrSerials) {
+		mSerials.push_back(i.release());
+	}
 	mXBeeNet = ptrXBeeNet.release();
 	mTcpNet = ptrTcpNet.release();
 	mRouter = ptrRouter.release();
@@ -109,10 +114,13 @@ throw (Utils::Error)
 	// stop all services
 	*mLog.info() << "STOP";
 	try {
+		// the ports first => no data is routed inline to the stopped services
+		for (auto i: mSerials) {
+			i->stop();
+		}
 		mRouter->stop();
 		mTcpNet->stop();
 		mXBeeNet->stop();
-		mSerial->stop();
 		mSignalProcessor->stop();
 		mProcessor->stop();
 	} catch (std::exception& e) {
@@ -126,7 +134,9 @@ throw (Utils::Error)
 		delete mRouter;
 		delete mTcpNet;
 		delete mXBeeNet;
-		delete mSerial;
+		for (auto i: mSerials) {
+			delete i;
+		}
 		delete mSignalProcessor;
 		delete mProcessor;
 	} catch (std::exception& e) {
@@ -141,10 +151,13 @@ void Application::run() throw () {
 	try {
 		mProcessor->start();
 		mSignalProcessor->start();
-		mSerial->start();
 		mXBeeNet->start();
 		mTcpNet->start();
 		mRouter->start();
+		// the ports last => the inline routing sees the started services
+		for (auto i: mSerials) {
+			i->start();
+		}
 		started = true;
 	} catch (std::exception& e) {
 		*mLog.error() << UTILS_STR_FUNCTION << ", starting, error: " << e.what();
@@ -157,6 +170,15 @@ void Application::run() throw () {
 	}
 }
 
+SerialPort* Application::getSerial(const std::string& name) {
+	for (auto i: mSerials) {
+		if (i->getName() == name) {
+			return i;
+		}
+	}
+	return nullptr;
+}
+
 void Application::stop(const std::string& reason) throw () {
 	*mLog.debug() << UTILS_STR_FUNCTION << ", reason: " << reason;
 	mSem.post();
@@ -20,6 +20,8 @@
 #include "Logger.h"
 /* External Includes */
 /* System Includes */
+#include <string>
+#include <vector>
 
 /* Forward declaration */
 namespace Utils {
@@ -67,7 +69,8 @@ public:
 
 	// Available services
 	Utils::CommandProcessor&		getProcessor() {return *mProcessor;}
-	SerialPort&					getSerial() {return *mSerial;}
+	// nullptr if the port is not configured
+	SerialPort*					getSerial(const std::string& name);
 	XBeeNet&						getXBeeNet() {return *mXBeeNet;}
 	TcpNet&						getTcpNet() {return *mTcpNet;}
 	Router&						getRouter() {return *mRouter;}
@@ -80,7 +83,7 @@ private:
 	// Services
 	Utils::CommandProcessor*			mProcessor;
 	SignalProcessor*					mSignalProcessor;
-	SerialPort*						mSerial;
+	std::vector<SerialPort*>			mSerials;
 	XBeeNet*							mXBeeNet;
 	TcpNet*							mTcpNet;
 	Router*							mRouter;
@@ -0,0 +1,100 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: Utils. Pool of recyclable buffers.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef UTILS_BUFFER_POOL_H_
+#define UTILS_BUFFER_POOL_H_
+
+/* Internal Includes */
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+namespace Utils {
+
+/**
+ * Pool of recyclable buffers.
+ * Buffers keep the capacity between uses => no allocations in steady state.
+ * Lock free ring: one thread gets the buffers, another one puts them back.
+ */
+class BufferPool {
+public:
+	typedef std::vector<uint8_t> Buffer;
+
+	/**
+	 * Constructor
+	 *
+	 * @param capacity reserved size of every buffer
+	 * @param limit maximum number of free buffers kept by the pool
+	 */
+	BufferPool(std::size_t capacity, std::size_t limit)
+	:
+		mCapacity(capacity),
+		mSlots(limit + 1),
+		mHead(0),
+		mTail(0)
+	{
+	}
+
+	/**
+	 * Gets the buffer, the content is undefined.
+	 * Called by the consumer thread only.
+	 */
+	std::unique_ptr<Buffer> get() {
+		const std::size_t tail = mTail.load(std::memory_order_relaxed);
+		if (tail != mHead.load(std::memory_order_acquire)) {
+			std::unique_ptr<Buffer> res(std::move(mSlots[tail]));
+			mTail.store(next(tail), std::memory_order_release);
+			return res;
+		}
+		std::unique_ptr<Buffer> res(new Buffer);
+		res->reserve(mCapacity);
+		return res;
+	}
+
+	/**
+	 * Returns the buffer to the pool, the buffer is freed if the pool is full.
+	 * Called by the producer thread only.
+	 */
+	void put(std::unique_ptr<Buffer> buffer) {
+		if (!buffer || buffer->capacity() < mCapacity) {
+			return;
+		}
+		const std::size_t head = mHead.load(std::memory_order_relaxed);
+		if (next(head) == mTail.load(std::memory_order_acquire)) {
+			return;
+		}
+		mSlots[head] = std::move(buffer);
+		mHead.store(next(head), std::memory_order_release);
+	}
+private:
+	const std::size_t							mCapacity;
+	std::vector<std::unique_ptr<Buffer> >		mSlots;
+	std::atomic<std::size_t>					mHead;
+	std::atomic<std::size_t>					mTail;
+
+	std::size_t next(std::size_t i) const {
+		return (i + 1) % mSlots.size();
+	}
+
+	// Do not copy
+	BufferPool(const BufferPool&);
+	BufferPool &operator=(const BufferPool&);
+};
+
+} /* namespace Utils */
+
+#endif /* UTILS_BUFFER_POOL_H_ */
@@ -17,6 +17,8 @@
 /* Internal Includes */
 /* External Includes */
 /* System Includes */
+#include <stdint.h>
+#include <atomic>
 
 
 namespace Utils {
@@ -26,7 +28,7 @@ namespace Utils {
  */
 class Command {
 public:
-	Command() {
+	Command(): mNext(nullptr), mStream(0), mLane(0) {
 	};
 
 	virtual ~Command() {
@@ -37,6 +39,12 @@ public:
 	 */
 	virtual void execute() = 0;
 protected:
+private:
+	friend class CommandProcessor;
+	// CommandProcessor queue link and lane => queuing doesn't allocate
+	std::atomic<Command*>	mNext;
+	uint64_t				mStream;
+	uint8_t					mLane;
 };
 
 } /* namespace Utils */
@@ -17,6 +17,12 @@
 /* External Includes */
 /* System Includes */
 #include <assert.h>
+#ifdef __linux__
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 
 
 namespace Utils {
@@ -25,16 +31,30 @@ CommandProcessor::CommandProcessor(const std::string& name)
 :
 	Utils::Thread(name + "-CmP"),
 	mLog(getName()),
-	mSem(0, 1)
+	mHead(&mStub),
+	mTail(&mStub),
+	mState(AWAKE)
+#ifndef __linux__
+	,mSem(0, 1)
+#endif
 {
 }
 
 CommandProcessor::~CommandProcessor() throw () {
 	_stop();
+	drainInbox();
+	while (!mQueueHigh.empty()) {
+		delete mQueueHigh.front();
+		mQueueHigh.pop();
+	}
 	while (!mQueue.empty()) {
-		delete mQueue.front();
+		delete mQueue.front().cmd;
 		mQueue.pop();
 	}
+	for (auto& i: mDelayed) {
+		delete i.second;
+	}
+	mDelayed.clear();
 }
 
 void CommandProcessor::stop(void) {
@@ -53,42 +73,203 @@ void CommandProcessor::start(void)
 }
 
 void CommandProcessor::onStop() {
-	mSem.post();
+	wakeUp();
 }
 
 void CommandProcessor::loop(void)
 {
 	while (isAlive()) {
-		// wait a new command
-		mSem.wait();
-		mMtx.lock();
+		drainInbox();
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		bool isDelayed = false;
+		std::chrono::steady_clock::time_point due;
+		{
+			std::lock_guard<std::mutex> locker(mMtx);
+			// move due delayed commands to the queue
+			while (!mDelayed.empty() && mDelayed.begin()->first <= now) {
+				mQueue.push(Item{mDelayed.begin()->second, NO_STREAM});
+				mDelayed.erase(mDelayed.begin());
+			}
+			if (!mDelayed.empty()) {
+				isDelayed = true;
+				due = mDelayed.begin()->first;
+			}
+		}
+		if (mQueueHigh.empty() && mQueue.empty()) {
+			// wait a new command or the nearest delayed one
+			sleep(isDelayed ? &due : NULL);
+			continue;
+		}
 		//process all commands
-		while (!mQueue.empty()) {
-			std::unique_ptr<Command> cmd(mQueue.front());
-			mQueue.pop();
-			// release mutex to allow adding new commands
-			mMtx.unlock();
+		while (!mQueueHigh.empty() || !mQueue.empty()) {
+			std::unique_ptr<Command> cmd(pop());
 			try {
 				cmd->execute();
 			} catch (std::exception &e) {
 				*mLog.error() << UTILS_STR_FUNCTION
 						<<", Command::execute, error: " << e.what();
 			}
-			mMtx.lock();
+			// the new high lane commands are seen immediately
+			drainInbox();
 		}
-		mMtx.unlock();
 	}
 	*mLog.debug() << UTILS_STR_FUNCTION << ", done";
 }
 
+void CommandProcessor::push(Command* cmd)
+{
+	// Vyukov intrusive MPSC queue, wait-free for producers
+	cmd->mNext.store(nullptr, std::memory_order_relaxed);
+	Command* prev = mHead.exchange(cmd, std::memory_order_seq_cst);
+	prev->mNext.store(cmd, std::memory_order_release);
+}
+
+Command* CommandProcessor::popInbox()
+{
+	Command* tail = mTail;
+	Command* next = tail->mNext.load(std::memory_order_acquire);
+	if (tail == &mStub) {
+		if (!next) {
+			return nullptr;
+		}
+		mTail = next;
+		tail = next;
+		next = next->mNext.load(std::memory_order_acquire);
+	}
+	if (next) {
+		mTail = next;
+		return tail;
+	}
+	if (tail != mHead.load(std::memory_order_acquire)) {
+		// a producer is between the exchange and the link => the next drain gets it
+		return nullptr;
+	}
+	push(&mStub);
+	next = tail->mNext.load(std::memory_order_acquire);
+	if (next) {
+		mTail = next;
+		return tail;
+	}
+	return nullptr;
+}
+
+void CommandProcessor::drainInbox()
+{
+	Command* cmd;
+	while ((cmd = popInbox())) {
+		Lane::Type lane = static_cast<Lane::Type>(cmd->mLane);
+		const uint64_t stream = cmd->mStream;
+		if (lane == Lane::HIGH && stream != NO_STREAM && mPending.count(stream)) {
+			// keep the stream order
+			lane = Lane::NORMAL;
+		}
+		if (lane == Lane::HIGH) {
+			mQueueHigh.push(cmd);
+		} else {
+			mQueue.push(Item{cmd, stream});
+			if (stream != NO_STREAM) {
+				++mPending[stream];
+			}
+		}
+	}
+}
+
+Command* CommandProcessor::pop()
+{
+	// strict priority
+	if (!mQueueHigh.empty()) {
+		Command* cmd = mQueueHigh.front();
+		mQueueHigh.pop();
+		return cmd;
+	}
+	const Item item = mQueue.front();
+	mQueue.pop();
+	if (item.stream != NO_STREAM) {
+		auto it = mPending.find(item.stream);
+		if (it != mPending.end() && --it->second == 0) {
+			mPending.erase(it);
+		}
+	}
+	return item.cmd;
+}
+
+void CommandProcessor::sleep(const std::chrono::steady_clock::time_point* due)
+{
+	mState.store(SLEEPING, std::memory_order_seq_cst);
+	// re-check after the state is published => a concurrent push wakes us up
+	const bool isEmpty = (mTail == &mStub && mHead.load(std::memory_order_seq_cst) == &mStub);
+	bool isDue = false;
+	{
+		std::lock_guard<std::mutex> locker(mMtx);
+		isDue = !mDelayed.empty() && (!due || mDelayed.begin()->first < *due);
+	}
+	if (isEmpty && !isDue && isAlive()) {
+		uint32_t timeoutMs = 0;
+		if (due) {
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			timeoutMs = (*due > now) ? static_cast<uint32_t>(
+					std::chrono::duration_cast<std::chrono::milliseconds>(*due - now).count() + 1) : 0;
+		}
+		if (!due || timeoutMs) {
+#ifdef __linux__
+			struct timespec ts = {static_cast<time_t>(timeoutMs / 1000), static_cast<long>(timeoutMs % 1000) * 1000000};
+			::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&mState), FUTEX_WAIT_PRIVATE,
+					static_cast<uint32_t>(SLEEPING), due ? &ts : NULL, NULL, 0);
+#else
+			if (due) {
+				mSem.wait(timeoutMs);
+			} else {
+				mSem.wait();
+			}
+#endif
+		}
+	}
+	mState.store(AWAKE, std::memory_order_seq_cst);
+}
+
+void CommandProcessor::wakeUp()
+{
+	if (mState.load(std::memory_order_seq_cst) == SLEEPING
+			&& mState.exchange(AWAKE, std::memory_order_seq_cst) == SLEEPING)
+	{
+#ifdef __linux__
+		::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&mState), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+		mSem.post();
+#endif
+	}
+}
+
 void CommandProcessor::process(std::unique_ptr<Command> command)
+{
+	process(std::move(command), Lane::NORMAL, NO_STREAM);
+}
+
+void CommandProcessor::process(std::unique_ptr<Command> command, Lane::Type lane, uint64_t stream)
 {
 	assert(command.get());
 	if (command.get()) {
-		std::lock_guard<std::mutex> locker(mMtx);
-		mQueue.push(command.get());
-		command.release();
-		mSem.post();
+		Command* cmd = command.release();
+		cmd->mLane = static_cast<uint8_t>(lane);
+		cmd->mStream = stream;
+		push(cmd);
+		wakeUp();
+	}
+}
+
+void CommandProcessor::process(std::unique_ptr<Command> command, uint32_t delayMs)
+{
+	assert(command.get());
+	if (command.get()) {
+		{
+			std::lock_guard<std::mutex> locker(mMtx);
+			mDelayed.insert(std::make_pair(
+					std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs),
+					command.get()));
+			command.release();
+		}
+		// wake up to recalculate the waiting time
+		wakeUp();
 	}
 }
 
@@ -23,16 +23,37 @@
 /* System Includes */
 #include <string>
 #include <queue>
+#include <map>
+#include <unordered_map>
 #include <mutex>
+#include <chrono>
+#include <atomic>
 
 
 namespace Utils {
 
 /**
  * Asynchronous Command invoker class.
+ * Commands are added to a lock-free inbox (intrusive multi-producer single-consumer queue),
+ * the processor thread moves them to the lanes and sleeps only when everything is processed.
  */
 class CommandProcessor: private Utils::Thread {
 public:
+	/**
+	 * Queue lanes, the high lane is always drained first.
+	 */
+	struct Lane {
+		typedef enum {
+			NORMAL,
+			HIGH
+		} Type;
+	};
+
+	/**
+	 * Stream identifier of the commands without ordering requirements.
+	 */
+	static const uint64_t NO_STREAM = 0;
+
 	CommandProcessor(const std::string&);
 
 	~CommandProcessor() throw ();
@@ -52,12 +73,54 @@ public:
 	 */
 	void process(std::unique_ptr<Command>);
 
+	/**
+	 * Adds new command for processing after the delay.
+	 *
+	 * @param delayMs minimum delay in milliseconds
+	 */
+	void process(std::unique_ptr<Command>, uint32_t delayMs);
+
+	/**
+	 * Adds new command for processing in the lane.
+	 * Commands of the same stream are never reordered: the high lane command
+	 * is put to the normal lane if its stream has pending normal commands.
+	 *
+	 * @param lane queue lane
+	 * @param stream ordering stream identifier, e.g. the device address
+	 */
+	void process(std::unique_ptr<Command>, Lane::Type lane, uint64_t stream);
+
 private:
+	// Types
+	class Stub: public Command {
+		void execute() {}
+	};
+	struct Item {
+		Command*	cmd;
+		uint64_t	stream;
+	};
+	typedef enum {
+		AWAKE,
+		SLEEPING
+	} State;
 	// Objects
 	Utils::Logger					mLog;
-	std::queue<Command*>			mQueue;
-	Utils::Semaphore				mSem;
+	// inbox, producers push to the head, the processor pops from the tail
+	std::atomic<Command*>			mHead;
+	Command*						mTail;
+	Stub							mStub;
+	// lanes are accessed by the processor thread only
+	std::queue<Command*>			mQueueHigh;
+	std::queue<Item>				mQueue;
+	// number of commands in the normal lane per stream
+	std::unordered_map<uint64_t, uint32_t>	mPending;
+	std::multimap<std::chrono::steady_clock::time_point, Command*>	mDelayed;
 	std::mutex						mMtx;
+	// the producers wake up the processor only if it sleeps
+	std::atomic<uint32_t>			mState;
+#ifndef __linux__
+	Utils::Semaphore				mSem;
+#endif
 
 	// Do not copy
 	CommandProcessor(const CommandProcessor&);
@@ -67,6 +130,12 @@ private:
 	void onStop();
 	void loop();
 	void _stop(void);
+	void push(Command*);
+	Command* popInbox();
+	void drainInbox();
+	Command* pop();
+	void sleep(const std::chrono::steady_clock::time_point* due);
+	void wakeUp();
 };
 
 } /* namespace Utils */
@@ -16,6 +16,7 @@
 #include "ConfigurationImpl.h"
 #include "Error.h"
 #include "Logger.h"
+#include "XBeeFrame.h"
 /* External Includes */
 /* System Includes */
 #include <cstdlib>
@@ -79,10 +80,87 @@ throw (Utils::Error)
 				get().logger.level = LoggerLevel::fromString(value);
 			}
 			get().logger.file = config.get<std::string>("logger.file", get().logger.file);
-			get().serial.name = config.get<std::string>("serial.name");
-			get().serial.baud = config.get<uint32_t>("serial.baud");
+			// defaults of the ports
+			get().serial.apiMode = config.get<uint32_t>("serial.api-mode", get().serial.apiMode);
+			get().serial.flowControl = config.get<std::string>("serial.flow-control", get().serial.flowControl);
+			{
+				const boost::optional<boost::property_tree::ptree&> ports = config.get_child_optional("serial.ports");
+				if (ports) {
+					const uint32_t baud = config.get<uint32_t>("serial.baud", get().serial.ports.front().baud);
+					get().serial.ports.clear();
+					for (const auto& i: *ports) {
+						get().serial.ports.push_back({
+							i.second.get<std::string>("name"),
+							i.second.get<uint32_t>("baud", baud),
+							i.second.get<uint32_t>("api-mode", get().serial.apiMode),
+							i.second.get<std::string>("flow-control", get().serial.flowControl)
+						});
+					}
+					if (get().serial.ports.empty()) {
+						throw Utils::Error("serial.ports must not be empty");
+					}
+				} else {
+					get().serial.ports.front().name = config.get<std::string>("serial.name");
+					get().serial.ports.front().baud = config.get<uint32_t>("serial.baud");
+					get().serial.ports.front().apiMode = get().serial.apiMode;
+					get().serial.ports.front().flowControl = get().serial.flowControl;
+				}
+			}
+			for (const Configuration::Serial::Port& i: get().serial.ports) {
+				if (i.apiMode != 1 && i.apiMode != 2) {
+					throw Utils::Error("serial.api-mode must be 1 or 2, port: " + i.name);
+				}
+				if (i.flowControl != "none" && i.flowControl != "hardware" && i.flowControl != "software") {
+					throw Utils::Error("serial.flow-control must be none, hardware or software, port: " + i.name);
+				}
+				if (i.flowControl == "software" && i.apiMode != 2) {
+					// XON/XOFF bytes are escaped only in API mode 2
+					throw Utils::Error("serial.flow-control software requires serial.api-mode 2, port: " + i.name);
+				}
+			}
+			get().serial.profile = config.get<std::string>("serial.profile", get().serial.profile);
+			if (get().serial.profile != "latency" && get().serial.profile != "throughput") {
+				throw Utils::Error("serial.profile must be latency or throughput");
+			}
+			get().serial.readSize = config.get<uint32_t>("serial.read-size", get().serial.readSize);
+			get().serial.baudMax = config.get<uint32_t>("serial.baud-max", get().serial.baudMax);
+			{
+				XBeeFrameBaudRate::type code;
+				if (get().serial.baudMax && !XBeeFrameBaudRate::toCode(get().serial.baudMax, code)) {
+					throw Utils::Error("serial.baud-max must be a standard rate from 1200 to 921600");
+				}
+			}
+			get().xbee.txWindow = config.get<uint32_t>("xbee.tx-window", get().xbee.txWindow);
+			if (!get().xbee.txWindow) {
+				throw Utils::Error("xbee.tx-window must not be 0");
+			}
+			get().xbee.txRetries = config.get<uint32_t>("xbee.tx-retries", get().xbee.txRetries);
+			get().xbee.txQueueSize = config.get<uint32_t>("xbee.tx-queue-size", get().xbee.txQueueSize);
+			get().xbee.txTimeoutMs = config.get<uint32_t>("xbee.tx-timeout-ms", get().xbee.txTimeoutMs);
+			get().xbee.mtu = config.get<uint32_t>("xbee.mtu", get().xbee.mtu);
+			get().xbee.txEncryption = config.get<bool>("xbee.tx-encryption", get().xbee.txEncryption);
+			get().xbee.txCoalesceMs = config.get<uint32_t>("xbee.tx-coalesce-ms", get().xbee.txCoalesceMs);
+			get().router.mode = config.get<std::string>("router.mode", get().router.mode);
+			if (get().router.mode != "threaded" && get().router.mode != "inline") {
+				throw Utils::Error("router.mode must be threaded or inline");
+			}
 			get().tcp.address = config.get<std::string>("tcp.address");
 			get().tcp.port = config.get<uint32_t>("tcp.port");
+			{
+				get().tcp.routes.clear();
+				const boost::optional<boost::property_tree::ptree&> routes = config.get_child_optional("tcp.routes");
+				if (routes) {
+					for (const auto& i: *routes) {
+						const uint64_t mask = std::stoull(i.second.get<std::string>("mask", "FFFFFFFFFFFFFFFF"), nullptr, 16);
+						get().tcp.routes.push_back({
+							std::stoull(i.second.get<std::string>("mac"), nullptr, 16) & mask,
+							mask,
+							i.second.get<std::string>("address", get().tcp.address),
+							i.second.get<uint32_t>("port", get().tcp.port)
+						});
+					}
+				}
+			}
 			get().mqtt.resetOnConnect = config.get<bool>("mqtt.reset-on-connect", get().mqtt.resetOnConnect);
 			get().mqtt.forceAuth = config.get<bool>("mqtt.force-auth", get().mqtt.forceAuth);
 			get().jwt.expirationSec = config.get<uint32_t>("jwt.expiration-sec", get().jwt.expirationSec);
@@ -151,10 +229,30 @@ void Configuration::dump() const {
 	*ConfigurationImpl::mLog.info() << "Configuration:";
 	*ConfigurationImpl::mLog.info() << "logger.level             = " << LoggerLevel::toString(logger.level);
 	*ConfigurationImpl::mLog.info() << "logger.file              = " << logger.file;
-	*ConfigurationImpl::mLog.info() << "serial.name              = " << serial.name;
-	*ConfigurationImpl::mLog.info() << "serial.boud              = " << serial.baud;
+	for (const Serial::Port& i: serial.ports) {
+		*ConfigurationImpl::mLog.info() << "serial.name              = " << i.name;
+		*ConfigurationImpl::mLog.info() << "serial.boud              = " << i.baud;
+		*ConfigurationImpl::mLog.info() << "serial.api-mode          = " << i.apiMode;
+		*ConfigurationImpl::mLog.info() << "serial.flow-control      = " << i.flowControl;
+	}
+	*ConfigurationImpl::mLog.info() << "serial.profile           = " << serial.profile;
+	*ConfigurationImpl::mLog.info() << "serial.read-size         = " << (serial.readSize ? std::to_string(serial.readSize) : "<AUTO>");
+	*ConfigurationImpl::mLog.info() << "serial.baud-max          = " << (serial.baudMax ? std::to_string(serial.baudMax) : "<NA>");
+	*ConfigurationImpl::mLog.info() << "xbee.tx-window           = " << xbee.txWindow;
+	*ConfigurationImpl::mLog.info() << "xbee.tx-retries          = " << xbee.txRetries;
+	*ConfigurationImpl::mLog.info() << "xbee.tx-queue-size       = " << xbee.txQueueSize;
+	*ConfigurationImpl::mLog.info() << "xbee.tx-timeout-ms       = " << xbee.txTimeoutMs;
+	*ConfigurationImpl::mLog.info() << "xbee.mtu                 = " << (xbee.mtu ? std::to_string(xbee.mtu) : "<AUTO>");
+	*ConfigurationImpl::mLog.info() << "xbee.tx-encryption       = " << putBool(xbee.txEncryption);
+	*ConfigurationImpl::mLog.info() << "xbee.tx-coalesce-ms      = " << xbee.txCoalesceMs;
+	*ConfigurationImpl::mLog.info() << "router.mode              = " << router.mode;
 	*ConfigurationImpl::mLog.info() << "tcp.address              = " << tcp.address;
 	*ConfigurationImpl::mLog.info() << "tcp.port                 = " << tcp.port;
+	for (const Tcp::Route& i: tcp.routes) {
+		*ConfigurationImpl::mLog.info() << "tcp.routes               = "
+				<< std::uppercase << std::hex << i.mac << "/" << i.mask << std::dec
+				<< " -> " << i.address << ":" << i.port;
+	}
 	*ConfigurationImpl::mLog.info() << "mqtt.reset-on-connect    = " << putBool(mqtt.resetOnConnect);
 	*ConfigurationImpl::mLog.info() << "mqtt.force-auth          = " << putBool(mqtt.forceAuth);
 	*ConfigurationImpl::mLog.info() << "jwt.expiration-sec       = " << jwt.expirationSec;
@@ -20,6 +20,7 @@
 /* System Includes */
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 namespace Utils {
 
@@ -63,15 +64,47 @@ public:
 	} logger = {LoggerLevel::TRACE, ""};
 
 	struct Serial {
-		std::string									name;
-		uint32_t										baud;
-
-	} serial = {"/dev/serial", 57600};
+		// one port per coordinator
+		struct Port {
+			std::string								name;
+			uint32_t									baud;
+			uint32_t									apiMode;
+			std::string								flowControl;
+		};
+		std::vector<Port>							ports;
+		uint32_t										apiMode;
+		std::string									profile;
+		uint32_t										readSize;
+		std::string									flowControl;
+		uint32_t										baudMax;
+	} serial = {{{"/dev/serial", 57600, 2, "none"}}, 2, "throughput", 0, "none", 0};
+
+	struct XBee {
+		uint32_t										txWindow;
+		uint32_t										txRetries;
+		uint32_t										txQueueSize;
+		uint32_t										txTimeoutMs;
+		uint32_t										mtu;
+		bool											txEncryption;
+		uint32_t										txCoalesceMs;
+	} xbee = {2, 0, 32, 30000, 0, false, 0};
+
+	struct Router {
+		std::string									mode;
+	} router = {"threaded"};
 
 	struct Tcp {
 		std::string									address;
 		uint32_t										port;
-	} tcp = {"localhost", 1883};
+		// upstream of the devices with matching MAC
+		struct Route {
+			uint64_t									mac;
+			uint64_t									mask;
+			std::string								address;
+			uint32_t									port;
+		};
+		std::vector<Route>							routes;
+	} tcp = {"localhost", 1883, {}};
 
 	struct Mqtt {
 		bool											resetOnConnect;
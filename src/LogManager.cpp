@@ -13,6 +13,7 @@
 
 /* Internal Includes */
 #include "LogManager.h"
+#include "Logger.h"
 #include "Configuration.h"
 /* External Includes */
 /* System Includes */
@@ -94,6 +95,7 @@ throw (Utils::Error)
 void LogManager::start() {
 	std::lock_guard<std::recursive_mutex> locker(mMtx);
 	prepareOs();
+	Logger::setLevel(getLogLevelCurrent());
 	setState(State::OK);
 	flushBuffer();
 }
@@ -19,6 +19,8 @@
 
 namespace Utils {
 
+std::atomic<int> Logger::mLevel(LoggerLevel::TRACE);
+
 LogStream& LogStream::flush() {
 	std::string log(str());
 	if (!log.empty()) {
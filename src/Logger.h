@@ -24,6 +24,7 @@
 #include <sstream>
 #include <vector>
 #include <memory>
+#include <atomic>
 
 
 namespace Utils {
@@ -116,7 +117,27 @@ public:
 	 * @return the logger name
 	 */
 	const std::string& getName() const {return mName;}
+
+	/**
+	 * Checks if the lines of the level are logged.
+	 * Building of the line allocates => the hot path checks the level first.
+	 *
+	 * @param level the line log level
+	 * @return true if the line is logged
+	 */
+	static bool isEnabled(LoggerLevel::Type level)
+		{return level <= mLevel.load(std::memory_order_relaxed);}
+
+	/**
+	 * Sets the level of the logged lines.
+	 * Everything is logged till the configuration is read, see LogManager::start().
+	 *
+	 * @param level the current log level
+	 */
+	static void setLevel(LoggerLevel::Type level)
+		{mLevel.store(level, std::memory_order_relaxed);}
 private:
+	static std::atomic<int>	mLevel;
 	std::string				mName;
 };
 
@@ -134,18 +155,18 @@ inline LogStream& endLog(LogStream& os) {
  */
 class __iom__put_array {
 public:
-	inline explicit __iom__put_array(const std::vector<uint8_t>& data)
-		: mData(data) {}
+	inline explicit __iom__put_array(const uint8_t* data, std::size_t size)
+		: mData(data), mSize(size) {}
 
 	inline friend std::ostream& operator<<(std::ostream& os, const __iom__put_array& data)
 	{
 		// save flags
 		std::ios::fmtflags f(os.flags());
 		// print
-		for (auto i = data.mData.begin(); i!=data.mData.end(); i++) {
+		for (std::size_t i = 0; i < data.mSize; i++) {
 			os << std::uppercase << std::hex << std::setw(2) << std::setfill('0')
-				<< (int)(*i);
-			if (i+1 != data.mData.end()) {
+				<< (int)(data.mData[i]);
+			if (i+1 != data.mSize) {
 				os << " ";
 			}
 		}
@@ -154,14 +175,22 @@ public:
 		return os;
 	}
 private:
-	const std::vector<uint8_t>&		mData;
+	const uint8_t*			mData;
+	const std::size_t		mSize;
 };
 
 /**
  * Print Array content in HEX mode with 'XX' format
  */
 inline __iom__put_array putArray(const std::vector<uint8_t>& data) {
-	return __iom__put_array(data);
+	return __iom__put_array(data.data(), data.size());
+};
+
+/**
+ * Print Array content in HEX mode with 'XX' format
+ */
+inline __iom__put_array putArray(const uint8_t* data, std::size_t size) {
+	return __iom__put_array(data, size);
 };
 
 /**
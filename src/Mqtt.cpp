@@ -35,13 +35,13 @@ Mqtt::~Mqtt()
 {
 }
 
-void Mqtt::closeOnConnect(Networking::Buffer& buffer, TcpNetConnection** connection_p)
+void Mqtt::closeOnConnect(Networking::Buffer& buffer, std::size_t offset, TcpNetConnection** connection_p)
 {
 	TcpNetConnection* connection = *connection_p;
 	bool resetOnConnect = Utils::Configuration::get().mqtt.resetOnConnect;
 	if (connection && resetOnConnect) {
 		MQTTPacket_connectData message = MQTTPacket_connectData_initializer;
-		if (MQTTDeserialize_connect(&message, static_cast<unsigned char*>(&(buffer[0])), static_cast<std::size_t>(buffer.size()))) {
+		if (MQTTDeserialize_connect(&message, static_cast<unsigned char*>(buffer.data() + offset), static_cast<std::size_t>(buffer.size() - offset))) {
 			*mLog.info() << "MQTT_CONNECT => Reestablish Connection";
 			connection->close();
 			*connection_p = nullptr;
@@ -49,12 +49,12 @@ void Mqtt::closeOnConnect(Networking::Buffer& buffer, TcpNetConnection** connect
 	}
 }
 
-void Mqtt::forceAuth(Networking::Buffer& buffer, TcpNetConnection& connection)
+void Mqtt::forceAuth(Networking::Buffer& buffer, std::size_t& offset, TcpNetConnection& connection)
 {
 	bool forceAuth = Utils::Configuration::get().mqtt.forceAuth;
 	if (forceAuth) {
 		MQTTPacket_connectData message = MQTTPacket_connectData_initializer;
-		if (MQTTDeserialize_connect(&message, static_cast<unsigned char*>(&(buffer[0])), static_cast<std::size_t>(buffer.size()))) {
+		if (MQTTDeserialize_connect(&message, static_cast<unsigned char*>(buffer.data() + offset), static_cast<std::size_t>(buffer.size() - offset))) {
 			if (Utils::Configuration::get().jwt.key.empty()) {
 				*mLog.warn() << "mqtt.force-auth is set => provide JWT key value";
 			} else {
@@ -78,6 +78,7 @@ void Mqtt::forceAuth(Networking::Buffer& buffer, TcpNetConnection& connection)
 				if (len > 0) {
 					tmp_buffer.resize(len);
 					buffer = std::move(tmp_buffer);
+					offset = 0;
 					connection.setProtocol(TcpNetProtocol::MQTT);
 					connection.setExpiration(jwt_exp);
 				} else {
@@ -88,6 +89,42 @@ void Mqtt::forceAuth(Networking::Buffer& buffer, TcpNetConnection& connection)
 	}
 }
 
+bool Mqtt::getPacketSize(const uint8_t* data, std::size_t size, std::size_t& packetSize)
+{
+	// Control byte + up to 4 bytes of Remaining Length
+	std::size_t remaining = 0;
+	for (std::size_t i = 1; i <= 4; i++) {
+		if (i >= size) {
+			return false;
+		}
+		remaining |= static_cast<std::size_t>(data[i] & 0x7F) << (7*(i-1));
+		if (!(data[i] & 0x80)) {
+			packetSize = 1 + i + remaining;
+			return true;
+		}
+	}
+	packetSize = size;
+	return true;
+}
+
+bool Mqtt::isControl(const uint8_t* data, std::size_t size)
+{
+	std::size_t offset = 0;
+	while (offset < size) {
+		std::size_t packetSize = 0;
+		if (!getPacketSize(data + offset, size - offset, packetSize) || packetSize > size - offset) {
+			return false;
+		}
+		const uint8_t type = data[offset] >> 4;
+		// 0 and 15 are reserved, 3 is PUBLISH
+		if (type == 0 || type == 3 || type == 15) {
+			return false;
+		}
+		offset += packetSize;
+	}
+	return size > 0;
+}
+
 void Mqtt::closeOnExpire(TcpNetConnection** connection_p)
 {
 	TcpNetConnection* connection = *connection_p;
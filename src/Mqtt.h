@@ -43,18 +43,43 @@ public:
 
 	/**
 	 * Closes connection on CONNECT message.
+	 *
+	 * @param offset start of the message in the buffer
 	 */
-	void closeOnConnect(Networking::Buffer& buffer, TcpNetConnection** connection);
+	void closeOnConnect(Networking::Buffer& buffer, std::size_t offset, TcpNetConnection** connection);
 
 	/**
 	 * Adds authentication to CONNECT message.
+	 *
+	 * @param offset start of the message in the buffer, zero if the message is re-encoded
 	 */
-	void forceAuth(Networking::Buffer& buffer, TcpNetConnection& connection);
+	void forceAuth(Networking::Buffer& buffer, std::size_t& offset, TcpNetConnection& connection);
 
 	/**
 	 * Closes expired connections.
 	 */
 	void closeOnExpire(TcpNetConnection** connection);
+
+	/**
+	 * Gets the MQTT packet size from the fixed header.
+	 * Malformed header => the whole available data is reported as one packet.
+	 *
+	 * @param data the packet start
+	 * @param size available bytes
+	 * @param packetSize the packet size including the fixed header
+	 * @return false if the fixed header is incomplete
+	 */
+	static bool getPacketSize(const uint8_t* data, std::size_t size, std::size_t& packetSize);
+
+	/**
+	 * Checks that the data contains only whole MQTT control packets,
+	 * e.g. CONNECT, CONNACK, PUBACK, PINGREQ, PINGRESP, but no PUBLISH.
+	 *
+	 * @param data the packet start
+	 * @param size available bytes
+	 * @return true if the data is small and latency critical
+	 */
+	static bool isControl(const uint8_t* data, std::size_t size);
 private:
 	// Objects
 	Utils::Logger									mLog;
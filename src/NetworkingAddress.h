@@ -22,59 +22,97 @@
 #include <stdint.h>
 #include <memory>
 #include <sstream>
+#include <map>
+#include <mutex>
 
 
 namespace Networking {
 
+/**
+ * The address is interned: one immortal instance per value.
+ * The pointer is the handle => it is copied as is and compared as an integer,
+ * the string forms are built once.
+ */
 class Address {
 public:
 	virtual ~Address() {}
 
 	Origin::Type getOrigin() const {return mOrigin;}
-	virtual bool isEqual(const Address& v) const {return mOrigin==v.mOrigin;}
-	virtual std::unique_ptr<Address> clone() const = 0;
-	virtual std::string toString() const = 0;
-	virtual std::string getValueString() const = 0;
+	bool isEqual(const Address& v) const {return this==&v;}
+	const std::string& toString() const {return mString;}
+	const std::string& getValueString() const {return mValueString;}
 protected:
-	Address(Origin::Type o): mOrigin(o) {}
+	Address(Origin::Type o, const std::string& value): mOrigin(o), mValueString(value) {
+		std::stringstream ss;
+		ss << mOrigin << "[" << mValueString << "]";
+		mString = ss.str();
+	}
 private:
 	Origin::Type		mOrigin;
+	std::string			mValueString;
+	std::string			mString;
+
+	// Do not copy
+	Address(const Address&);
+	Address &operator=(const Address&);
 };
 
 template<enum Origin::Type tOrigin, class tVal> class AddressImpl: public Address {
 public:
 	virtual ~AddressImpl() {}
-	AddressImpl(const tVal& v): Address(tOrigin), mVal(v) {}
 
-	const tVal& get() const {return mVal;}
-	std::unique_ptr<Address> clone() const
-			{return std::unique_ptr<Address>(new AddressImpl(*this));}
-	bool isEqual(const Address& v) const {
-		bool res = false;
-		const AddressImpl* addr = dynamic_cast<const AddressImpl*>(&v);
-		if (addr) { res = (Address::isEqual(v) && mVal==addr->mVal); }
-		return res;
+	/**
+	 * Gets the address of the value, the first call creates it.
+	 * Takes a global lock => for the configuration and the first sight of a device,
+	 * the data path keeps the result.
+	 */
+	static const AddressImpl* intern(const tVal& v) {
+		static std::mutex mtx;
+		static std::map<tVal, std::unique_ptr<const AddressImpl> > addresses;
+		std::lock_guard<std::mutex> locker(mtx);
+		std::unique_ptr<const AddressImpl>& res = addresses[v];
+		if (!res) {
+			res.reset(new AddressImpl(v));
+		}
+		return res.get();
 	}
-	std::string toString() const {
-		std::stringstream ss;
-		ss << getOrigin() << "[" << mVal << "]";
-		return ss.str();
-	}
-	std::string getValueString() const {
+
+	const tVal& get() const {return mVal;}
+private:
+	tVal				mVal;
+
+	AddressImpl(const tVal& v): Address(tOrigin, toValueString(v)), mVal(v) {}
+
+	static std::string toValueString(const tVal& v) {
 		std::stringstream ss;
-		ss << mVal;
+		ss << v;
 		return ss.str();
 	}
-private:
-	tVal				mVal;
 };
 
-typedef std::string												AddressSerialValT;
+typedef struct AddressSerialValT_ {
+	// the name is shared by all copies => copying doesn't allocate
+	AddressSerialValT_(const std::string& v):value(std::make_shared<const std::string>(v)) {}
+	bool operator==(const AddressSerialValT_& v) const {
+		return value==v.value || *value==*v.value;
+	}
+	bool operator<(const AddressSerialValT_& v) const {
+		return *value<*v.value;
+	}
+	operator const std::string&() const {return *value;}
+	inline friend std::ostream& operator<<(std::ostream& os, const AddressSerialValT_& obj) {
+		return os << *obj.value;
+	}
+	std::shared_ptr<const std::string>	value;
+} AddressSerialValT;
 typedef struct AddressXbeeValT_ {
 	AddressXbeeValT_(uint64_t v):value(v) {}
 	bool operator==(const AddressXbeeValT_& v) const {
 		return value==v.value;
 	}
+	bool operator<(const AddressXbeeValT_& v) const {
+		return value<v.value;
+	}
 	operator uint64_t() const {return value;}
 	inline friend std::ostream& operator<<(std::ostream& os, const AddressXbeeValT_& obj) {
 		std::ios::fmtflags f(os.flags());
@@ -89,6 +127,9 @@ typedef struct AddressTcpValT_ {
 	bool operator==(const AddressTcpValT_& v) const {
 		return host==v.host && port==v.port;
 	}
+	bool operator<(const AddressTcpValT_& v) const {
+		return host<v.host || (host==v.host && port<v.port);
+	}
 	inline friend std::ostream& operator<<(std::ostream& os, const AddressTcpValT_& obj) {
 		return os << obj.host << ":" << obj.port;
 	}
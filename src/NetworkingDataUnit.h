@@ -17,6 +17,7 @@
 /* Internal Includes */
 #include "NetworkingDefs.h"
 #include "NetworkingAddress.h"
+#include "Command.h"
 /* External Includes */
 /* System Includes */
 #include <memory>
@@ -26,20 +27,31 @@
 
 namespace Networking {
 
-class DataUnit {
+/**
+ * The unit is queued to the Router processor as is => no wrapping command.
+ * Every unit type is executed by own route, see Router.cpp.
+ */
+class DataUnit: public Utils::Command {
 public:
 	virtual ~DataUnit() {}
 
 	Origin::Type getOrigin() const {return mOrigin;}
-	const Address* getFrom() const {return mFrom.get();}
-	const Address* getTo() const {return mTo.get();}
+	const Address* getFrom() const {return mFrom;}
+	const Address* getTo() const {return mTo;}
+	/**
+	 * Time of the data reception from serial port, creation time by default
+	 */
+	Time getTime() const {return mTime;}
+	void setTime(Time time) {mTime = time;}
 protected:
-	DataUnit(Origin::Type o, std::unique_ptr<Address> from, std::unique_ptr<Address> to)
-	: mOrigin(o), mFrom(std::move(from)), mTo(std::move(to)) {}
+	DataUnit(Origin::Type o, const Address* from, const Address* to)
+	: mOrigin(o), mFrom(from), mTo(to), mTime(std::chrono::steady_clock::now()) {}
 private:
 	Origin::Type					mOrigin;
-	std::unique_ptr<Address>		mFrom;
-	std::unique_ptr<Address>		mTo;
+	// interned => not owned
+	const Address*					mFrom;
+	const Address*					mTo;
+	Time							mTime;
 };
 
 template<enum Origin::Type tOrigin> class DataUnitImpl: public DataUnit {
@@ -47,14 +59,27 @@ public:
 	virtual ~DataUnitImpl() {}
 	DataUnitImpl(
 			std::unique_ptr<Buffer> data,
-			std::unique_ptr<Address> from, std::unique_ptr<Address> to)
+			const Address* from, const Address* to,
+			std::size_t offset = 0)
 	:
-		DataUnit(tOrigin, std::move(from), std::move(to)),
-		mData(std::move(data)) {}
+		DataUnit(tOrigin, from, to),
+		mData(std::move(data)),
+		mOffset(offset) {}
 
 	std::unique_ptr<Buffer> popData() {return std::move(mData);}
+	const Buffer* getData() const {return mData.get();}
+	/**
+	 * Start of the payload inside the data, e.g. the frame header is not cut off
+	 */
+	std::size_t getOffset() const {return mOffset;}
+
+	/**
+	 * Routes the unit
+	 */
+	void execute();
 private:
 	std::unique_ptr<Buffer>			mData;
+	std::size_t						mOffset;
 };
 
 typedef DataUnitImpl<Origin::SERIAL>				DataUnitSerial;
@@ -62,6 +87,12 @@ typedef DataUnitImpl<Origin::XBEE_ENCODER>			DataUnitXBeeEncoder;
 typedef DataUnitImpl<Origin::XBEE>					DataUnitXBee;
 typedef DataUnitImpl<Origin::TCP>					DataUnitTcp;
 
+// routes are resolved at compile time
+template<> void DataUnitSerial::execute();
+template<> void DataUnitXBeeEncoder::execute();
+template<> void DataUnitXBee::execute();
+template<> void DataUnitTcp::execute();
+
 } /* namespace Networking */
 
 #endif /* NETWORKING_DATA_UNIT_H_ */
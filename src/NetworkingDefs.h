@@ -20,10 +20,12 @@
 #include <vector>
 #include <stdint.h>
 #include <ostream>
+#include <chrono>
 
 namespace Networking {
 
 typedef std::vector<uint8_t> Buffer;
+typedef std::chrono::steady_clock::time_point Time;
 
 namespace Origin {
 	enum Type {
@@ -15,57 +15,104 @@
 #include "Router.h"
 #include "NetworkingDataUnit.h"
 #include "CommandProcessor.h"
-#include "Error.h"
 #include "Application.h"
 #include "Configuration.h"
 #include "XBeeNet.h"
 #include "TcpNet.h"
 #include "SerialPort.h"
+#include "Mqtt.h"
 /* External Includes */
 /* System Includes */
+#include <stdint.h>
+#include <algorithm>
+#include <bitset>
+#include <vector>
+#include <unordered_map>
 
 
 ///////////////////// RouterContext /////////////////////
 struct RouterContext {
 	Utils::CommandProcessor							processor;
-	RouterContext(const std::string& name) : processor(name) {}
+	// inline mode => the unit is routed on the caller thread
+	bool											isInline;
+	// destination of the XBee network data
+	const Networking::AddressTcp*					upstream;
+	struct Upstream {
+		uint64_t										mac;
+		uint64_t										mask;
+		const Networking::AddressTcp*				address;
+	};
+	// routes of a single device, by the MAC address
+	std::unordered_map<uint64_t, const Networking::AddressTcp*>	exact;
+	// routes of the device groups, sorted by the mask => the most specific is the first.
+	// Built by the constructor and read only => routing needs no locking.
+	std::vector<Upstream>							upstreams;
+	// destination of the encoded frames, by the interned port address.
+	// Built by start() => the ports are resolved once.
+	std::unordered_map<const Networking::Address*, SerialPort*>	serials;
+	RouterContext(const std::string& name) : processor(name), isInline(false), upstream(NULL) {}
 };
 
-///////////////////// RouterCommands /////////////////////
-class RouterCommands: public Utils::Command {
-public:
-	virtual ~RouterCommands() {}
-};
+///////////////////// Routes /////////////////////
+namespace Networking {
 
-class RouterCommandsProcess: public RouterCommands {
-public:
-	typedef std::function<void(std::unique_ptr<Networking::DataUnit>)> Cbk;
-	RouterCommandsProcess(Cbk cbk, std::unique_ptr<Networking::DataUnit> data)
-	:
-		mCbk(cbk),
-		mData(std::move(data))
-	{}
-
-	void execute() {
-		mCbk(std::move(mData));
-	}
-private:
-	Cbk											mCbk;
-	std::unique_ptr<Networking::DataUnit>		mData;
-};
+template<> void DataUnitSerial::execute() {
+	Application::get().getRouter().route(*this);
+}
+
+template<> void DataUnitXBeeEncoder::execute() {
+	Application::get().getRouter().route(*this);
+}
+
+template<> void DataUnitXBee::execute() {
+	Application::get().getRouter().route(*this);
+}
+
+template<> void DataUnitTcp::execute() {
+	Application::get().getRouter().route(*this);
+}
+
+} /* namespace Networking */
 
 ///////////////////// Router /////////////////////
 Router::Router()
 :
 	mLog(__FUNCTION__),
 	mCtx(new RouterContext(mLog.getName()))
-{}
+{
+	const Utils::Configuration& config = Utils::Configuration::get();
+	mCtx->isInline = (config.router.mode == "inline");
+	mCtx->upstream = Networking::AddressTcp::intern({config.tcp.address, config.tcp.port});
+	for (const Utils::Configuration::Tcp::Route& i: config.tcp.routes) {
+		const Networking::AddressTcp* address = Networking::AddressTcp::intern({i.address, i.port});
+		if (i.mask == UINT64_MAX) {
+			// the first configured route of the device wins
+			if (mCtx->exact.insert(std::make_pair(i.mac, address)).second) {
+				*mLog.info() << "Route " << Networking::AddressXbeeValT(i.mac) << " -> " << address->get();
+			}
+		} else {
+			mCtx->upstreams.push_back({i.mac, i.mask, address});
+		}
+	}
+	std::stable_sort(mCtx->upstreams.begin(), mCtx->upstreams.end(),
+		[] (const RouterContext::Upstream& a, const RouterContext::Upstream& b) {
+			return std::bitset<64>(a.mask).count() > std::bitset<64>(b.mask).count();
+		}
+	);
+	for (const RouterContext::Upstream& i: mCtx->upstreams) {
+		*mLog.info() << "Route " << Networking::AddressXbeeValT(i.mac)
+				<< "/" << Networking::AddressXbeeValT(i.mask) << " -> " << i.address->get();
+	}
+}
 
 Router::~Router() {
 	delete mCtx;
 }
 
 void Router::start() {
+	for (const Utils::Configuration::Serial::Port& i: Utils::Configuration::get().serial.ports) {
+		mCtx->serials[Networking::AddressSerial::intern(i.name)] = Application::get().getSerial(i.name);
+	}
 	mCtx->processor.start();
 }
 
@@ -74,71 +121,76 @@ void Router::stop() {
 }
 
 void Router::process(std::unique_ptr<Networking::DataUnit> unit) {
-	std::unique_ptr<Utils::Command> cmd (new RouterCommandsProcess(
-		[this] (std::unique_ptr<Networking::DataUnit> a) {
-				onProcess(std::move(a));
-		},
-		std::move(unit)
-	));
-	mCtx->processor.process(std::move(cmd));
+	if (mCtx->isInline) {
+		// the routes are read only after start(), the networks lock own state
+		unit->execute();
+		return;
+	}
+	// MQTT control packets overtake the bulk data of other devices
+	Utils::CommandProcessor::Lane::Type lane = Utils::CommandProcessor::Lane::NORMAL;
+	uint64_t stream = Utils::CommandProcessor::NO_STREAM;
+	const Networking::Buffer* data = NULL;
+	std::size_t offset = 0;
+	const Networking::Address* device = NULL;
+	switch (unit->getOrigin()) {
+		case Networking::Origin::XBEE:
+			data = static_cast<const Networking::DataUnitXBee&>(*unit).getData();
+			offset = static_cast<const Networking::DataUnitXBee&>(*unit).getOffset();
+			device = unit->getFrom();
+			break;
+		case Networking::Origin::TCP:
+			data = static_cast<const Networking::DataUnitTcp&>(*unit).getData();
+			device = unit->getTo();
+			break;
+		default:
+			break;
+	}
+	if (data && device && device->getOrigin() == Networking::Origin::XBEE) {
+		stream = static_cast<const Networking::AddressXBeeNet*>(device)->get().value;
+		if (Mqtt::isControl(data->data() + offset, data->size() - offset)) {
+			lane = Utils::CommandProcessor::Lane::HIGH;
+		}
+	}
+	mCtx->processor.process(std::move(unit), lane, stream);
 }
 
 ///////////////////// Router::Internal /////////////////////
-void Router::onProcess(std::unique_ptr<Networking::DataUnit> unit) {
-	try {
-		try {
-			switch(unit->getOrigin()) {
-				case Networking::Origin::SERIAL:
-				{
-					Networking::DataUnitSerial* u = dynamic_cast<Networking::DataUnitSerial*>(unit.get());
-					if (!u) {
-						throw Utils::Error("Wrong unit type");
-					}
-					Application::get().getXBeeNet().from(u->popData());
-				}
-					break;
-				case Networking::Origin::XBEE_ENCODER:
-				{
-					Networking::DataUnitXBeeEncoder* u = dynamic_cast<Networking::DataUnitXBeeEncoder*>(unit.get());
-					if (!u) {
-						throw Utils::Error("Wrong unit type");
-					}
-					Application::get().getSerial().write(u->popData());
-				}
-					break;
-				case Networking::Origin::XBEE:
-				{
-					Networking::DataUnitXBee* u = dynamic_cast<Networking::DataUnitXBee*>(unit.get());
-					if (!u) {
-						throw Utils::Error("Wrong unit type");
-					}
-					Networking::AddressTcp to(
-						{
-							Utils::Configuration::get().tcp.address,
-							Utils::Configuration::get().tcp.port
-						}
-					);
-					*mLog.debug() << u->getFrom()->toString() << " -> " << to.toString();
-					Application::get().getTcpNet().send(u->getFrom(), &to, u->popData());
-				}
-					break;
-				case Networking::Origin::TCP:
-				{
-					Networking::DataUnitTcp* u = dynamic_cast<Networking::DataUnitTcp*>(unit.get());
-					if (!u) {
-						throw Utils::Error("Wrong unit type");
-					}
-					*mLog.debug() << u->getFrom()->toString() << " -> " << u->getTo()->toString();
-					Application::get().getXBeeNet().to(u->getFrom(), u->getTo(), u->popData());
-				}
-					break;
-				default:
-					throw Utils::Error("Origin is not implemented");
-			}
-		} catch (std::exception& e) {
-			throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(Router));
+void Router::route(Networking::DataUnitSerial& u) {
+	Application::get().getXBeeNet().from(u.getFrom(), u.popData(), u.getTime());
+}
+
+void Router::route(Networking::DataUnitXBeeEncoder& u) {
+	// the encoder addresses the frame to the port of the coordinator
+	const Networking::AddressSerial* port = static_cast<const Networking::AddressSerial*>(u.getTo());
+	std::unordered_map<const Networking::Address*, SerialPort*>::const_iterator i = mCtx->serials.find(port);
+	SerialPort* serial = (i != mCtx->serials.end()) ? i->second : nullptr;
+	if (serial) {
+		serial->write(u.popData());
+	} else {
+		*mLog.error() << UTILS_STR_FUNCTION << ", error: Port is not available, port: " << port->get();
+	}
+}
+
+void Router::route(Networking::DataUnitXBee& u) {
+	const Networking::AddressXBeeNet* from = static_cast<const Networking::AddressXBeeNet*>(u.getFrom());
+	Application::get().getTcpNet().send(from, getUpstream(from->get()), u.popData(), u.getOffset(), u.getTime());
+}
+
+void Router::route(Networking::DataUnitTcp& u) {
+	Application::get().getXBeeNet().to(u.getFrom(), u.getTo(), u.popData());
+}
+
+const Networking::AddressTcp* Router::getUpstream(const Networking::AddressXbeeValT& device) const {
+	std::unordered_map<uint64_t, const Networking::AddressTcp*>::const_iterator exact =
+			mCtx->exact.find(device.value);
+	if (exact != mCtx->exact.end()) {
+		return exact->second;
+	}
+	// a few device groups => the linear match
+	for (const RouterContext::Upstream& i: mCtx->upstreams) {
+		if ((device.value & i.mask) == i.mac) {
+			return i.address;
 		}
-	} catch (std::exception& e) {
-		*mLog.error() << UTILS_STR_FUNCTION << ", error: "<<e.what();
 	}
+	return mCtx->upstream;
 }
@@ -17,12 +17,12 @@
 /* Internal Includes */
 #include "Logger.h"
 /* External Includes */
+#include "NetworkingDataUnit.h"
 /* System Includes */
 #include <memory>
 
 /* Forward declaration */
 struct RouterContext;
-namespace Networking {class DataUnit;}
 
 /**
  * Routing events and data between networks
@@ -50,7 +50,8 @@ public:
 	void stop();
 
 	/**
-	 * Routes the data unit to configured direction
+	 * Routes the data unit to configured direction.
+	 * The unit is queued as is, the route is selected by the unit type.
 	 *
 	 * @param unit the data unit
 	 */
@@ -64,8 +65,15 @@ private:
 	Router(const Router&);
 	Router &operator=(const Router&);
 
-	// Methods
-	void onProcess(std::unique_ptr<Networking::DataUnit>);
+	// Routes
+	void route(Networking::DataUnitSerial&);
+	void route(Networking::DataUnitXBeeEncoder&);
+	void route(Networking::DataUnitXBee&);
+	void route(Networking::DataUnitTcp&);
+
+	const Networking::AddressTcp* getUpstream(const Networking::AddressXbeeValT&) const;
+
+	template<Networking::Origin::Type> friend class Networking::DataUnitImpl;
 };
 
 #endif /* ROUTER_H_ */
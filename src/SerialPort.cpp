@@ -15,18 +15,33 @@
 #include "SerialPort.h"
 #include "SerialPortCommand.h"
 #include "Thread.h"
-#include "Semaphore.h"
 #include "CommandProcessor.h"
 #include "Configuration.h"
 #include "Error.h"
 #include "Application.h"
 #include "Router.h"
 #include "NetworkingDataUnit.h"
+#include "BufferPool.h"
+#include "TcpNet.h"
+#include "XBeeNet.h"
 /* External Includes */
 /* System Includes */
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include <mutex>
+#include <deque>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#ifdef __linux__
+#include <linux/serial.h>
+#include <sys/inotify.h>
+#endif
 
 /* Forward declaration */
 class SerialPortReader;
@@ -34,7 +49,14 @@ class SerialPortWriter;
 class SerialPortOpener;
 
 #define SERIAL_PORT_READER_BUFFER_SIZE		512
-#define SERIAL_PORT_OPENER_ERROR_TM_MS		5000		// 5 sec
+#define SERIAL_PORT_READER_BUFFER_SIZE_LATENCY	64
+#define SERIAL_PORT_USB_LATENCY_MS			1
+#define SERIAL_PORT_USB_LATENCY_MS_DEFAULT	16
+#define SERIAL_PORT_READER_POOL_SIZE		64
+#define SERIAL_PORT_OPENER_RETRY_MIN_MS		100
+#define SERIAL_PORT_OPENER_RETRY_MAX_MS		5000		// 5 sec
+#define SERIAL_PORT_WRITER_HIGH_WATERMARK	4096		// bytes
+#define SERIAL_PORT_WRITER_LOW_WATERMARK	1024		// bytes
 
 ///////////////////// TcpNetIoService /////////////////////
 class SerialPortIoService: private Utils::Thread {
@@ -87,11 +109,16 @@ struct SerialPortContext {
 	Utils::CommandProcessor							processor;
 	SerialPortIoService								ioService;
 	std::string										portName;
+	const Networking::AddressSerial*				portAddress;
 	uint32_t										portBaud;
+	bool											isLowLatency;
+	std::size_t										readSize;
+	boost::asio::serial_port_base::flow_control::type	flowControl;
+	// the pending handlers share the reader, writer and port => the port could be renewed any time
 	struct Serial {
-		std::unique_ptr<boost::asio::serial_port>		port;
-		std::unique_ptr<SerialPortReader>				portReader;
-		std::unique_ptr<SerialPortWriter>				portWriter;
+		std::shared_ptr<boost::asio::serial_port>		port;
+		std::shared_ptr<SerialPortReader>				portReader;
+		std::shared_ptr<SerialPortWriter>				portWriter;
 
 		~Serial() {
 			if (port) {
@@ -101,57 +128,74 @@ struct SerialPortContext {
 		}
 	};
 	std::unique_ptr<Serial>							serial;
-	std::unique_ptr<SerialPortOpener>				portOpener;
+	std::shared_ptr<SerialPortOpener>				portOpener;
+	Utils::BufferPool								readPool;
 
-	SerialPortContext(const std::string& name) : processor(name), portBaud(0) {}
+	SerialPortContext(const std::string& name, const std::string& port)
+	:
+		processor(name),
+		portName(port),
+		portAddress(Networking::AddressSerial::intern(port)),
+		portBaud(0),
+		isLowLatency(false),
+		readSize(SERIAL_PORT_READER_BUFFER_SIZE),
+		flowControl(boost::asio::serial_port_base::flow_control::none),
+		readPool(SERIAL_PORT_READER_BUFFER_SIZE, SERIAL_PORT_READER_POOL_SIZE)
+	{}
 };
 
 ///////////////////// SerialPortReader /////////////////////
-class SerialPortReader {
+class SerialPortReader: public std::enable_shared_from_this<SerialPortReader> {
 public:
-	SerialPortReader(SerialPortContext& ctx)
-	throw (Utils::Error):
+	SerialPortReader(SerialPort& owner, SerialPortContext& ctx)
+	throw ():
 		mLog(__FUNCTION__),
+		mOwner(owner),
 		mCtx(ctx),
-		mPort(*(mCtx.serial->port))
+		mPort(mCtx.serial->port),
+		mAddress(mCtx.portAddress)
+	{}
+
+	void start()
+	throw (Utils::Error)
 	{
 		schedule();
 		*mLog.debug() << "Started";
 	}
-
-	~SerialPortReader() {
-		boost::system::error_code ec;
-		mPort.cancel(ec);
-	}
 private:
 	// Objects
 	Utils::Logger					mLog;
+	SerialPort&						mOwner;
 	SerialPortContext&				mCtx;
-	boost::asio::serial_port&		mPort;
-	uint8_t							mBufferRead[SERIAL_PORT_READER_BUFFER_SIZE];
+	std::shared_ptr<boost::asio::serial_port>	mPort;
+	const Networking::AddressSerial*	mAddress;
+	// pooled buffer of the current read operation
+	std::unique_ptr< std::vector<uint8_t> >	mBufferRead;
 
 	/**
 	 * Function is called on read operation finish.
 	 */
 	void onReceive(const boost::system::error_code& error, std::size_t qty) {
 		if (qty) {
-			std::unique_ptr< std::vector<uint8_t> > data
-						(new std::vector<uint8_t>(mBufferRead, mBufferRead+qty));
+			mBufferRead->resize(qty);
 			std::unique_ptr<Networking::DataUnit> unit(new Networking::DataUnitSerial(
-					std::move(data),
-					std::unique_ptr<Networking::Address>
-						(new Networking::AddressSerial(mCtx.portName)),
-					std::unique_ptr<Networking::Address>()
+					std::move(mBufferRead),
+					mAddress,
+					NULL
 			));
 			Application::get().getRouter().process(std::move(unit));
 		}
+		if (error == boost::asio::error::operation_aborted) {
+			// the port is closed by the owner
+			return;
+		}
 		try {
 			if (!qty && error) {
 				throw Utils::Error(error.message());
 			}
 			schedule();
 		} catch (Utils::Error& e) {
-			std::unique_ptr<Utils::Command> cmd (new SerialPortCommandClosed(e.what()));
+			std::unique_ptr<Utils::Command> cmd (new SerialPortCommandClosed(mOwner, e.what()));
 			Application::get().getProcessor().process(std::move(cmd));
 		}
 	}
@@ -164,14 +208,18 @@ private:
 	{
 		try {
 			try {
-				if (!mPort.is_open()) {
+				if (!mPort->is_open()) {
 					throw Utils::Error("Port is not opened");
 				}
-				mPort.async_read_some(
-						boost::asio::buffer(mBufferRead, SERIAL_PORT_READER_BUFFER_SIZE),
+				if (!mBufferRead) {
+					mBufferRead = mCtx.readPool.get();
+				}
+				mBufferRead->resize(mCtx.readSize);
+				mPort->async_read_some(
+						boost::asio::buffer(mBufferRead->data(), mCtx.readSize),
 						boost::bind(
 								&SerialPortReader::onReceive,
-								this, boost::asio::placeholders::error,
+								shared_from_this(), boost::asio::placeholders::error,
 								boost::asio::placeholders::bytes_transferred)
 				);
 			} catch (boost::system::system_error e) {
@@ -184,116 +232,375 @@ private:
 };
 
 ///////////////////// SerialPortWriter /////////////////////
-class SerialPortWriter {
+/**
+ * Asynchronous writer.
+ * Frames are queued and written by one gather-write operation,
+ * the caller is never blocked by the port.
+ * The port could be stopped by the flow control => the upstream is paused
+ * while the queued data is above the high watermark.
+ */
+class SerialPortWriter: public std::enable_shared_from_this<SerialPortWriter> {
 public:
-	SerialPortWriter(SerialPortContext& ctx)
+	typedef std::function<void(bool)> BlockCbk;
+
+	SerialPortWriter(SerialPortContext& ctx, BlockCbk cbk)
 	throw ():
 		mLog(__FUNCTION__),
-		mPort(*(ctx.serial->port))
+		mIoService(ctx.ioService.getIoService()),
+		mPort(ctx.serial->port),
+		mBlockCbk(cbk),
+		mIsWriting(false),
+		mIsBlocked(false),
+		mQueueSizeMax(0),
+		mQueueBytes(0)
 	{}
 
 	void write(std::unique_ptr< std::vector<uint8_t> > data) {
-		*mLog.debug() << UTILS_STR_FUNCTION <<", size: " << data->size();
-		try {
-			try {
-				std::size_t qty = boost::asio::write(mPort, boost::asio::buffer(&((*data)[0]), static_cast<std::size_t>(data->size())));
-				*mLog.debug() << UTILS_STR_FUNCTION << ", written : " << qty;
-				// TODO: process write`s return value
-			} catch (boost::system::system_error& e) {
-				throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(SerialPortWriter));
-			}
-		} catch (std::exception& e) {
-			*mLog.error() << UTILS_STR_FUNCTION << ", error: " << e.what();
+		std::lock_guard<std::mutex> locker(mMtx);
+		mQueueBytes += data->size();
+		mQueue.push_back(std::make_pair(std::move(data), Clock::now()));
+		if (mQueue.size() > mQueueSizeMax) {
+			mQueueSizeMax = mQueue.size();
+			*mLog.debug() << UTILS_STR_FUNCTION << ", queue.size-max: " << mQueueSizeMax;
+		}
+		if (!mIsBlocked && mQueueBytes > SERIAL_PORT_WRITER_HIGH_WATERMARK) {
+			*mLog.warn() << "Port is blocked, queued bytes: " << mQueueBytes << " => pause upstream";
+			setBlocked(true);
+		}
+		if (!mIsWriting) {
+			// the port is used by the I/O service thread only
+			mIsWriting = true;
+			mIoService.post(boost::bind(&SerialPortWriter::onStart, shared_from_this()));
 		}
 	}
 private:
+	typedef std::chrono::steady_clock Clock;
+	typedef std::pair<std::unique_ptr< std::vector<uint8_t> >, Clock::time_point> Item;
+
 	// Objects
 	Utils::Logger					mLog;
-	boost::asio::serial_port&		mPort;
+	boost::asio::io_service&		mIoService;
+	std::shared_ptr<boost::asio::serial_port>	mPort;
+	BlockCbk						mBlockCbk;
+	std::mutex						mMtx;
+	// waiting frames
+	std::deque<Item>				mQueue;
+	// frames of the current write operation
+	std::vector<Item>				mBatch;
+	bool							mIsWriting;
+	bool							mIsBlocked;
+	std::size_t						mQueueSizeMax;
+	// bytes of the waiting frames and of the current write operation
+	std::size_t						mQueueBytes;
+
+	void setBlocked(bool v) {
+		mIsBlocked = v;
+		mBlockCbk(v);
+	}
+
+	/**
+	 * Function is called on the I/O service thread to start writing.
+	 */
+	void onStart() {
+		std::lock_guard<std::mutex> locker(mMtx);
+		schedule();
+	}
+
+	/**
+	 * Starts writing of all queued frames
+	 */
+	void schedule() {
+		std::vector<boost::asio::const_buffer> buffers;
+		buffers.reserve(mQueue.size());
+		while (!mQueue.empty()) {
+			buffers.push_back(boost::asio::buffer(*mQueue.front().first));
+			mBatch.push_back(std::move(mQueue.front()));
+			mQueue.pop_front();
+		}
+		mIsWriting = true;
+		boost::asio::async_write(*mPort, buffers,
+				boost::bind(
+						&SerialPortWriter::onWrite,
+						shared_from_this(), boost::asio::placeholders::error,
+						boost::asio::placeholders::bytes_transferred)
+		);
+	}
+
+	/**
+	 * Function is called on write operation finish.
+	 */
+	void onWrite(const boost::system::error_code& error, std::size_t qty) {
+		std::lock_guard<std::mutex> locker(mMtx);
+		const Clock::time_point now = Clock::now();
+		if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+			*mLog.debug() << UTILS_STR_FUNCTION << ", frames: " << mBatch.size() << ", written: " << qty
+				<< ", latency-ms: " << std::chrono::duration_cast<std::chrono::milliseconds>(
+						now - mBatch.front().second).count()
+				<< ", queue.size: " << mQueue.size();
+		}
+		for (const Item& i: mBatch) {
+			mQueueBytes -= i.first->size();
+		}
+		mBatch.clear();
+		mIsWriting = false;
+		if (error) {
+			*mLog.error() << UTILS_STR_FUNCTION << ", error: " << error.message()
+				<< " => drop queued frames: " << mQueue.size();
+			mQueue.clear();
+			mQueueBytes = 0;
+		}
+		if (mIsBlocked && mQueueBytes <= SERIAL_PORT_WRITER_LOW_WATERMARK) {
+			*mLog.info() << "Port is unblocked, queued bytes: " << mQueueBytes << " => resume upstream";
+			setBlocked(false);
+		}
+		if (error) {
+			return;
+		}
+		if (!mQueue.empty()) {
+			schedule();
+		}
+	}
+};
+
+///////////////////// SerialPortTuner /////////////////////
+/**
+ * Applies the latency profile to the opened port.
+ * Every step is optional => failures are logged and skipped.
+ */
+class SerialPortTuner {
+public:
+	SerialPortTuner(SerialPortContext& ctx)
+	:
+		mLog(__FUNCTION__),
+		mCtx(ctx)
+	{}
+
+	void apply() {
+		const int fd = mCtx.serial->port->native_handle();
+		applyLowLatency(fd);
+		applyUsbLatency();
+	}
+private:
+	// Objects
+	Utils::Logger					mLog;
+	SerialPortContext&				mCtx;
+
+	/**
+	 * Driver low latency mode
+	 */
+	void applyLowLatency(int fd) {
+#ifdef __linux__
+		struct serial_struct info;
+		if (::ioctl(fd, TIOCGSERIAL, &info) != 0) {
+			*mLog.debug() << UTILS_STR_FUNCTION << ", not supported, errno: " << errno;
+			return;
+		}
+		if (mCtx.isLowLatency) {
+			info.flags |= ASYNC_LOW_LATENCY;
+		} else {
+			info.flags &= ~ASYNC_LOW_LATENCY;
+		}
+		if (::ioctl(fd, TIOCSSERIAL, &info) != 0) {
+			*mLog.warn() << UTILS_STR_FUNCTION << ", failed, errno: " << errno;
+		}
+#else
+		(void) fd;
+#endif
+	}
+
+	/**
+	 * Latency timer of the FTDI USB adapters
+	 */
+	void applyUsbLatency() {
+		char path[PATH_MAX];
+		if (!::realpath(mCtx.portName.c_str(), path)) {
+			return;
+		}
+		// symbolic links are resolved => the name is the kernel device name
+		std::string name(path);
+		name = name.substr(name.rfind('/') + 1);
+		const std::string file = "/sys/bus/usb-serial/devices/" + name + "/latency_timer";
+		uint32_t value = 0;
+		{
+			std::ifstream in(file.c_str());
+			if (!(in >> value)) {
+				*mLog.debug() << UTILS_STR_FUNCTION << ", not available: " << file;
+				return;
+			}
+		}
+		const uint32_t required = mCtx.isLowLatency ?
+				SERIAL_PORT_USB_LATENCY_MS : SERIAL_PORT_USB_LATENCY_MS_DEFAULT;
+		if (value != required) {
+			std::ofstream out(file.c_str());
+			if (!(out << required << std::endl)) {
+				*mLog.warn() << "USB latency timer is not writable: " << file << ", value: " << value << " ms";
+				return;
+			}
+			value = required;
+		}
+		*mLog.info() << "USB latency timer: " << value << " ms";
+	}
 };
 
 ///////////////////// SerialPortOpener /////////////////////
-class SerialPortOpener : private Utils::Thread {
+/**
+ * Opens the port on the I/O service thread.
+ * The port directory is watched by inotify => the port is opened as soon as
+ * the device node appears or gets the permissions. The retries with exponential
+ * back-off cover the missing directory and the systems without inotify.
+ */
+class SerialPortOpener: public std::enable_shared_from_this<SerialPortOpener> {
 public:
 	typedef std::function<bool(void)> Cbk;
 
-	SerialPortOpener(Cbk cbk)
+	SerialPortOpener(boost::asio::io_service& io, const std::string& portName, Cbk cbk)
 	throw ():
-		Utils::Thread(__FUNCTION__),
-		mLog(getName()),
+		mLog(__FUNCTION__),
+		mIoService(io),
 		mCbk(cbk),
-		mSem(0, 1),
+		mTimer(io),
+		mWatch(io),
+		mDelayMs(SERIAL_PORT_OPENER_RETRY_MIN_MS),
 		mDone(false)
-	{}
-
-	~SerialPortOpener() {
-		stop();
+	{
+		const std::size_t pos = portName.rfind('/');
+		mDir = (pos == std::string::npos) ? "." : (pos ? portName.substr(0, pos) : "/");
+		mFile = portName.substr(pos == std::string::npos ? 0 : pos + 1);
 	}
 
-	void onStop() {
-		mSem.post();
-	}
-
-	void start()
-	throw (Utils::Error)
-	{
-		Utils::Thread::start();
+	void start() {
+		mIoService.post(boost::bind(&SerialPortOpener::onOpen, shared_from_this()));
 	}
 
+	/**
+	 * Stops the attempts, the pending handlers only release the opener.
+	 * Must be called on the I/O service thread.
+	 */
 	void stop() {
-		Utils::Thread::stop();
+		mDone = true;
+		cancel();
 	}
 
 	bool isDone() const {return mDone;}
 private:
 	// Objects
 	Utils::Logger					mLog;
+	boost::asio::io_service&		mIoService;
 	Cbk								mCbk;
-	Utils::Semaphore				mSem;
+	boost::asio::deadline_timer		mTimer;
+	boost::asio::posix::stream_descriptor	mWatch;
+	std::string						mDir;
+	std::string						mFile;
+	uint32_t						mDelayMs;
 	bool							mDone;
+	uint8_t							mBufferEvents[1024];
+
+	void cancel() {
+		boost::system::error_code ec;
+		mTimer.cancel(ec);
+		mWatch.close(ec);
+	}
 
 	/**
-	 * Thread function to retry until open is done
+	 * Tries to open the port, schedules the next attempt on failure
 	 */
-	void loop() {
-		while (isAlive() && !isDone()) {
-			try {
-				if (mCbk()) {
-					setDone();
-				} else {
-					*mLog.debug() << UTILS_STR_FUNCTION << ", retry in "
-						<< SERIAL_PORT_OPENER_ERROR_TM_MS << " ms";
-					idle(SERIAL_PORT_OPENER_ERROR_TM_MS);
+	void onOpen() {
+		if (isDone()) {
+			return;
+		}
+		try {
+			if (mCbk()) {
+				mDone = true;
+				cancel();
+				return;
+			}
+		} catch (std::exception& e) {
+			*mLog.error() << UTILS_STR_FUNCTION << ", error: " << e.what();
+		}
+		startWatch();
+		*mLog.debug() << UTILS_STR_FUNCTION << ", retry in " << mDelayMs << " ms"
+				<< (mWatch.is_open() ? " or on device change" : "");
+		// re-arming cancels the pending wait
+		mTimer.expires_from_now(boost::posix_time::milliseconds(mDelayMs));
+		std::shared_ptr<SerialPortOpener> self(shared_from_this());
+		mTimer.async_wait(
+			[self] (const boost::system::error_code& error) {
+				if (!error) {
+					self->onOpen();
 				}
-			} catch (std::exception& e) {
-				*mLog.error() << UTILS_STR_FUNCTION << ", error: " << e.what();
 			}
+		);
+		mDelayMs = std::min(mDelayMs * 2, static_cast<uint32_t>(SERIAL_PORT_OPENER_RETRY_MAX_MS));
+	}
+
+	void startWatch() {
+#ifdef __linux__
+		if (mWatch.is_open()) {
+			return;
 		}
-		*mLog.debug() << UTILS_STR_FUNCTION << ", done";
+		const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (fd < 0) {
+			*mLog.debug() << UTILS_STR_FUNCTION << ", inotify is not available, errno: " << errno;
+			return;
+		}
+		if (::inotify_add_watch(fd, mDir.c_str(), IN_CREATE | IN_ATTRIB | IN_MOVED_TO) < 0) {
+			*mLog.debug() << UTILS_STR_FUNCTION << ", can't watch: " << mDir << ", errno: " << errno;
+			::close(fd);
+			return;
+		}
+		mWatch.assign(fd);
+		scheduleWatch();
+#endif
 	}
 
-	void setDone() {mDone = true;}
+	void scheduleWatch() {
+		mWatch.async_read_some(boost::asio::buffer(mBufferEvents, sizeof(mBufferEvents)),
+				boost::bind(
+						&SerialPortOpener::onWatch,
+						shared_from_this(), boost::asio::placeholders::error,
+						boost::asio::placeholders::bytes_transferred)
+		);
+	}
 
-	void idle(uint32_t timeMs) {
-		mSem.wait(timeMs);
+	/**
+	 * Function is called on the port directory change.
+	 */
+	void onWatch(const boost::system::error_code& error, std::size_t qty) {
+		if (error || isDone()) {
+			return;
+		}
+		bool isPort = false;
+#ifdef __linux__
+		for (std::size_t offset = 0; offset + sizeof(struct inotify_event) <= qty;) {
+			const struct inotify_event* event =
+					reinterpret_cast<const struct inotify_event*>(mBufferEvents + offset);
+			if (event->len && mFile == event->name) {
+				isPort = true;
+			}
+			offset += sizeof(struct inotify_event) + event->len;
+		}
+#endif
+		scheduleWatch();
+		if (isPort) {
+			*mLog.debug() << UTILS_STR_FUNCTION << ", device is changed: " << mFile;
+			mDelayMs = SERIAL_PORT_OPENER_RETRY_MIN_MS;
+			onOpen();
+		}
 	}
 };
 
 ///////////////////// SerialPortCommands /////////////////////
-void SerialPortCommandWrite::execute() {
-	Application::get().getSerial().onWrite(std::move(mData));
-}
-
 void SerialPortCommandClosed::execute() {
-	Application::get().getSerial().onClosed(mCause);
+	mOwner.onClosed(mCause);
 }
 
 ///////////////////// SerialPort /////////////////////
-SerialPort::SerialPort()
+SerialPort::SerialPort(std::size_t index)
 throw ()
 :
 	mLog(__FUNCTION__),
-	mCtx(new SerialPortContext(mLog.getName()))
+	mIndex(index),
+	mCtx(new SerialPortContext(mLog.getName(), Utils::Configuration::get().serial.ports[index].name))
 {
 }
 
@@ -321,23 +628,20 @@ throw (Utils::Error)
 void SerialPort::stop()
 throw ()
 {
+	// the opener runs on the I/O service thread and takes the lock
+	mCtx->ioService.stop();
 	std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
 	mCtx->processor.stop();
-	mCtx->ioService.stop();
+	// the I/O service thread is stopped => the handlers are not called anymore
+	if (mCtx->portOpener) {
+		mCtx->portOpener->stop();
+	}
 	mCtx->portOpener.reset();
 	mCtx->serial.reset();
 }
 
 void SerialPort::write(std::unique_ptr< std::vector<uint8_t> > buffer)
 throw ()
-{
-	std::unique_ptr<Utils::Command> cmd (new SerialPortCommandWrite(
-			std::move(buffer)));
-	mCtx->processor.process(std::move(cmd));
-}
-
-void SerialPort::onWrite(std::unique_ptr< std::vector<uint8_t> > buffer)
-throw ()
 {
 	std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
 	if (mCtx->serial && mCtx->serial->portWriter) {
@@ -347,15 +651,62 @@ throw ()
 	}
 }
 
+void SerialPort::setBaud(uint32_t baud)
+throw ()
+{
+	// the port belongs to the I/O service thread
+	mCtx->ioService.getIoService().post(
+		[this, baud] () {
+			std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
+			if (!mCtx->serial || !mCtx->serial->port || !mCtx->serial->port->is_open()) {
+				*mLog.warn() << "Baud is not changed, port is not opened: " << mCtx->portName;
+				return;
+			}
+			boost::system::error_code ec;
+			mCtx->serial->port->set_option(boost::asio::serial_port_base::baud_rate(baud), ec);
+			if (ec) {
+				*mLog.error() << "Baud is not changed, port: " << mCtx->portName << ", baud: " << baud
+					<< ", error: " << ec.message();
+				return;
+			}
+			mCtx->portBaud = baud;
+			*mLog.info() << "Port: " << mCtx->portName << " at " << baud;
+		}
+	);
+}
+
+void SerialPort::recycle(std::unique_ptr< std::vector<uint8_t> > buffer)
+throw ()
+{
+	mCtx->readPool.put(std::move(buffer));
+}
+
+const std::string& SerialPort::getName() const
+throw ()
+{
+	return mCtx->portName;
+}
+
 void SerialPort::startOpener()
 throw ()
 {
-	mCtx->portOpener.reset(new SerialPortOpener(
-			[this] (void) -> bool {
-				return onOpen();
+	// the opener and the port belong to the I/O service thread
+	mCtx->ioService.getIoService().post(
+		[this] () {
+			std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
+			if (mCtx->portOpener) {
+				mCtx->portOpener->stop();
 			}
-	));
-	mCtx->portOpener->start();
+			// closing aborts the pending operations, their handlers keep the objects alive
+			mCtx->serial.reset();
+			mCtx->portOpener.reset(new SerialPortOpener(mCtx->ioService.getIoService(), mCtx->portName,
+					[this] (void) -> bool {
+						return onOpen();
+					}
+			));
+			mCtx->portOpener->start();
+		}
+	);
 }
 
 bool SerialPort::onOpen()
@@ -366,8 +717,23 @@ throw ()
 	try {
 		try {
 			// Prepare
-			mCtx->portName = Utils::Configuration::get().serial.name;
-			mCtx->portBaud = Utils::Configuration::get().serial.baud;
+			mCtx->portBaud = Utils::Configuration::get().serial.ports[mIndex].baud;
+			mCtx->isLowLatency = (Utils::Configuration::get().serial.profile == "latency");
+			mCtx->readSize = Utils::Configuration::get().serial.readSize;
+			{
+				const std::string& flowControl = Utils::Configuration::get().serial.ports[mIndex].flowControl;
+				if (flowControl == "hardware") {
+					mCtx->flowControl = boost::asio::serial_port_base::flow_control::hardware;
+				} else if (flowControl == "software") {
+					mCtx->flowControl = boost::asio::serial_port_base::flow_control::software;
+				} else {
+					mCtx->flowControl = boost::asio::serial_port_base::flow_control::none;
+				}
+			}
+			if (!mCtx->readSize) {
+				mCtx->readSize = mCtx->isLowLatency ?
+						SERIAL_PORT_READER_BUFFER_SIZE_LATENCY : SERIAL_PORT_READER_BUFFER_SIZE;
+			}
 			*mLog.info() << "Opening port: " << mCtx->portName
 					<< " at " << mCtx->portBaud;
 			mCtx->serial.reset(new SerialPortContext::Serial);
@@ -377,11 +743,20 @@ throw ()
 			mCtx->serial->port->set_option(boost::asio::serial_port_base::character_size(8));
 			mCtx->serial->port->set_option(boost::asio::serial_port_base::stop_bits(boost::asio::serial_port_base::stop_bits::one));
 			mCtx->serial->port->set_option(boost::asio::serial_port_base::parity(boost::asio::serial_port_base::parity::none));
-			mCtx->serial->port->set_option(boost::asio::serial_port_base::flow_control(boost::asio::serial_port_base::flow_control::none));
+			mCtx->serial->port->set_option(boost::asio::serial_port_base::flow_control(mCtx->flowControl));
+			SerialPortTuner(*mCtx).apply();
 			*mLog.info() << "Port is opened";
-			mCtx->serial->portReader.reset(new SerialPortReader(*mCtx));
-			mCtx->serial->portWriter.reset(new SerialPortWriter(*mCtx));
+			mCtx->serial->portReader.reset(new SerialPortReader(*this, *mCtx));
+			mCtx->serial->portReader->start();
+			mCtx->serial->portWriter.reset(new SerialPortWriter(*mCtx,
+					[this] (bool isBlocked) {
+						Application::get().getTcpNet().pauseRead(
+								mCtx->portAddress, isBlocked);
+					}
+			));
 			res = true;
+			Application::get().getXBeeNet().opened(
+					mCtx->portAddress, mCtx->portBaud);
 		} catch (boost::system::system_error e) {
 			throw Utils::Error(e);
 		}
@@ -397,6 +772,8 @@ throw ()
 	std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
 	try {
 		*mLog.debug() << UTILS_STR_FUNCTION << ", cause: " << cause;
+		// queued frames are lost with the port => the upstream must not wait
+		Application::get().getTcpNet().pauseRead(mCtx->portAddress, false);
 		*mLog.info() << "Renew port";
 		startOpener();
 	} catch (Utils::Error& e) {
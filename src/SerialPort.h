@@ -27,15 +27,16 @@
 /* Forward declaration */
 struct SerialPortContext;
 class SerialPortCommandClosed;
-class SerialPortCommandWrite;
 
 
 class SerialPort {
 public:
 	/**
 	 * Constructor
+	 *
+	 * @param index index of the port in the configuration
 	 */
-	SerialPort() throw ();
+	explicit SerialPort(std::size_t index) throw ();
 
 	/**
 	 * Destructor
@@ -53,14 +54,38 @@ public:
 	void stop() throw ();
 
 	/**
-	 * Writes data to serial
+	 * Writes data to serial.
+	 * The data is queued, the caller is not blocked by the port.
 	 *
 	 * @param buffer data to be written
 	 */
 	void write(std::unique_ptr< std::vector<uint8_t> > buffer) throw ();
+
+	/**
+	 * Changes the baud rate of the opened port.
+	 * The rate is changed on the I/O service thread after the already posted operations.
+	 * The rate is reset to the configured one when the port is reopened.
+	 *
+	 * @param baud new baud rate
+	 */
+	void setBaud(uint32_t baud) throw ();
+
+	/**
+	 * Returns the received buffer to the read buffers pool.
+	 * Called by one thread at a time.
+	 *
+	 * @param buffer processed buffer
+	 */
+	void recycle(std::unique_ptr< std::vector<uint8_t> > buffer) throw ();
+
+	/**
+	 * Gets the port device name
+	 */
+	const std::string& getName() const throw ();
 private:
 	// Objects
 	Utils::Logger					mLog;
+	const std::size_t				mIndex;
 	SerialPortContext*				mCtx;
 
 	// Do not copy
@@ -68,14 +93,12 @@ private:
 	SerialPort &operator=(const SerialPort&);
 
 	// Internal
-	void onWrite(std::unique_ptr< std::vector<uint8_t> >) throw ();
 	bool onOpen() throw ();
 	void onClosed(const std::string& cause) throw ();
 
 	void startOpener() throw ();
 
 	friend class SerialPortCommandClosed;
-	friend class SerialPortCommandWrite;
 };
 
 #endif /* SERIAL_PORT_H_ */
@@ -26,6 +26,7 @@
 
 /* Forward declaration */
 struct SerialPortContext;
+class SerialPort;
 
 class SerialPortCommand: public Utils::Command {
 public:
@@ -33,24 +34,15 @@ public:
 	virtual ~SerialPortCommand() {}
 };
 
-class SerialPortCommandWrite: public SerialPortCommand {
-public:
-	SerialPortCommandWrite(std::unique_ptr< std::vector<uint8_t> > data)
-	:
-		mData(std::move(data))
-	{}
-	void execute();
-private:
-	std::unique_ptr< std::vector<uint8_t> >		mData;
-};
-
 class SerialPortCommandClosed: public SerialPortCommand {
 public:
-	SerialPortCommandClosed(const std::string& cause)
+	SerialPortCommandClosed(SerialPort& owner, const std::string& cause)
 	:
+		mOwner(owner),
 		mCause(cause) {};
 	void execute();
 private:
+	SerialPort&									mOwner;
 	std::string									mCause;
 };
 
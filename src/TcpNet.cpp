@@ -19,13 +19,18 @@
 #include "NetworkingAddress.h"
 #include "Application.h"
 #include "CommandProcessor.h"
-#include "Memory.h"
+#include "Configuration.h"
 #include "Thread.h"
 #include "Mqtt.h"
 /* External Includes */
 /* System Includes */
 #include <boost/asio.hpp>
+#include <unordered_set>
+#include <unordered_map>
 #include <assert.h>
+#include <sys/resource.h>
+
+#define TCP_NET_LATENCY_REPORT_QTY		100
 
 ///////////////////// TcpNetIoService /////////////////////
 class TcpNetIoService: private Utils::Thread {
@@ -77,34 +82,117 @@ struct TcpNetContext {
 	Utils::CommandProcessor							processor;
 	TcpNetIoService									ioService;
 	TcpNetDb										db;
-	TcpNetContext(const std::string& name) : processor(name) {}
+	// latency from the serial port reception till sending
+	struct Latency {
+		uint32_t										qty;
+		uint64_t										sumUs;
+		uint64_t										maxUs;
+		// context switches of the process at the report start
+		uint64_t										csw;
+	} latency;
+	// backpressure of the downlink
+	std::unordered_set<const Networking::Address*>	readPausedPorts;
+	std::unordered_set<uint64_t>					readPausedDevices;
+	// serial port of the device coordinator, by the interned device address
+	std::unordered_map<const Networking::Address*, const Networking::Address*>	devicePorts;
+	TcpNetContext(const std::string& name) : processor(name), latency({0, 0, 0, getContextSwitches()}) {}
+
+	static uint64_t getContextSwitches() {
+		struct rusage usage;
+		if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+			return 0;
+		}
+		return usage.ru_nvcsw + usage.ru_nivcsw;
+	}
 };
 
 ///////////////////// TcpNetCommands /////////////////////
 class TcpNetCommandSend: public TcpNetCommand {
 public:
-	typedef std::function<void(std::unique_ptr<Networking::Address>,
-			std::unique_ptr<Networking::Address>,
-			std::unique_ptr<Networking::Buffer>)> Cbk;
+	typedef std::function<void(const Networking::Address*,
+			const Networking::Address*,
+			std::unique_ptr<Networking::Buffer>, std::size_t, Networking::Time)> Cbk;
 	TcpNetCommandSend(TcpNet& owner, Cbk cbk,
 			const Networking::Address* from, const Networking::Address* to,
-			std::unique_ptr<Networking::Buffer> buffer)
+			std::unique_ptr<Networking::Buffer> buffer, std::size_t offset, Networking::Time time)
 	:
 		TcpNetCommand(owner),
 		mCbk(cbk),
-		mFrom(from->clone()),
-		mTo(to->clone()),
-		mData(std::move(buffer))
+		mFrom(from),
+		mTo(to),
+		mData(std::move(buffer)),
+		mOffset(offset),
+		mTime(time)
 	{}
 
 	void execute() {
-		mCbk(std::move(mFrom), std::move(mTo), std::move(mData));
+		mCbk(mFrom, mTo, std::move(mData), mOffset, mTime);
 	}
 private:
 	Cbk											mCbk;
-	std::unique_ptr<Networking::Address>		mFrom;
-	std::unique_ptr<Networking::Address>		mTo;
+	const Networking::Address*					mFrom;
+	const Networking::Address*					mTo;
 	std::unique_ptr<Networking::Buffer>			mData;
+	std::size_t									mOffset;
+	Networking::Time							mTime;
+};
+
+class TcpNetCommandPauseRead: public TcpNetCommand {
+public:
+	typedef std::function<void(const Networking::Address*, bool)> Cbk;
+	TcpNetCommandPauseRead(TcpNet& owner, Cbk cbk, const Networking::Address* source, bool isPaused)
+	:
+		TcpNetCommand(owner),
+		mCbk(cbk),
+		mSource(source),
+		mIsPaused(isPaused)
+	{}
+
+	void execute() {
+		mCbk(mSource, mIsPaused);
+	}
+private:
+	Cbk											mCbk;
+	const Networking::Address*					mSource;
+	bool										mIsPaused;
+};
+
+class TcpNetCommandRoute: public TcpNetCommand {
+public:
+	typedef std::function<void(const Networking::Address*, const Networking::Address*)> Cbk;
+	TcpNetCommandRoute(TcpNet& owner, Cbk cbk, const Networking::Address* device, const Networking::Address* port)
+	:
+		TcpNetCommand(owner),
+		mCbk(cbk),
+		mDevice(device),
+		mPort(port)
+	{}
+
+	void execute() {
+		mCbk(mDevice, mPort);
+	}
+private:
+	Cbk											mCbk;
+	const Networking::Address*					mDevice;
+	const Networking::Address*					mPort;
+};
+
+class TcpNetCommandReset: public TcpNetCommand {
+public:
+	typedef std::function<void(const Networking::Address*)> Cbk;
+	TcpNetCommandReset(TcpNet& owner, Cbk cbk, const Networking::Address* source)
+	:
+		TcpNetCommand(owner),
+		mCbk(cbk),
+		mSource(source)
+	{}
+
+	void execute() {
+		mCbk(mSource);
+	}
+private:
+	Cbk											mCbk;
+	const Networking::Address*					mSource;
 };
 
 ///////////////////// TcpNet /////////////////////
@@ -130,48 +218,99 @@ void TcpNet::stop() {
 }
 
 void TcpNet::send(const Networking::Address* from, const Networking::Address* to,
-			std::unique_ptr<Networking::Buffer> buffer)
+			std::unique_ptr<Networking::Buffer> buffer, std::size_t offset, Networking::Time time)
 throw ()
 {
 	assert(from);
 	assert(to);
 	assert(to->getOrigin()==Networking::Origin::TCP);
 	assert(buffer.get());
+	assert(offset <= buffer->size());
 
 	std::unique_ptr<Utils::Command> cmd (new TcpNetCommandSend(*this,
-		[this] (std::unique_ptr<Networking::Address> a, std::unique_ptr<Networking::Address> b,
-				std::unique_ptr<Networking::Buffer> c) {
-				onSend(std::move(a), std::move(b), std::move(c));
+		[this] (const Networking::Address* a, const Networking::Address* b,
+				std::unique_ptr<Networking::Buffer> c, std::size_t d, Networking::Time e) {
+				onSend(a, b, std::move(c), d, e);
 		},
 		from,
 		to,
-		std::move(buffer)
+		std::move(buffer),
+		offset,
+		time
+	));
+	mCtx->processor.process(std::move(cmd));
+}
+
+void TcpNet::pauseRead(const Networking::Address* source, bool isPaused)
+throw ()
+{
+	assert(source);
+	assert(source->getOrigin()==Networking::Origin::SERIAL || source->getOrigin()==Networking::Origin::XBEE);
+
+	std::unique_ptr<Utils::Command> cmd (new TcpNetCommandPauseRead(*this,
+		[this] (const Networking::Address* a, bool b) {
+				onPauseRead(a, b);
+		},
+		source,
+		isPaused
+	));
+	mCtx->processor.process(std::move(cmd));
+}
+
+void TcpNet::route(const Networking::Address* device, const Networking::Address* port)
+throw ()
+{
+	assert(device);
+	assert(device->getOrigin()==Networking::Origin::XBEE);
+	assert(port);
+	assert(port->getOrigin()==Networking::Origin::SERIAL);
+
+	std::unique_ptr<Utils::Command> cmd (new TcpNetCommandRoute(*this,
+		[this] (const Networking::Address* a, const Networking::Address* b) {
+				onRoute(a, b);
+		},
+		device,
+		port
+	));
+	mCtx->processor.process(std::move(cmd));
+}
+
+void TcpNet::reset(const Networking::Address* source)
+throw ()
+{
+	assert(source);
+	assert(source->getOrigin()==Networking::Origin::XBEE);
+
+	std::unique_ptr<Utils::Command> cmd (new TcpNetCommandReset(*this,
+		[this] (const Networking::Address* a) {
+				onReset(a);
+		},
+		source
 	));
 	mCtx->processor.process(std::move(cmd));
 }
 
 ///////////////////// TcpNet::Internal /////////////////////
-void TcpNet::onSend(std::unique_ptr<Networking::Address> from, std::unique_ptr<Networking::Address> to,
-		std::unique_ptr<Networking::Buffer> buffer)
+void TcpNet::onSend(const Networking::Address* from, const Networking::Address* to,
+		std::unique_ptr<Networking::Buffer> buffer, std::size_t offset, Networking::Time time)
 {
-	*mLog.debug() << UTILS_STR_FUNCTION << ", size:" << buffer->size();
+	if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+		*mLog.debug() << UTILS_STR_FUNCTION << ", size:" << buffer->size() - offset;
+	}
 	try {
 		TcpNetConnection* connection = mCtx->db.get(*from, *to);
-		Application::get().getMqtt().closeOnConnect(*buffer, &connection);
+		Application::get().getMqtt().closeOnConnect(*buffer, offset, &connection);
 		// mqtt may close the connection and clean the pointer
 		if (!connection) {
 			*mLog.info() << "Connecting, " << from->toString() << " <-> " << to->toString();
-			// prepare parameters
-			std::unique_ptr<Networking::AddressTcp> to_ =
-					Utils::dynamic_unique_ptr_cast<Networking::AddressTcp, Networking::Address>(to);
-			assert(to_.get());
 			// create new
 			std::unique_ptr<TcpNetConnection> t(new TcpNetConnection
-					(*this, std::move(from), std::move(to_)));
+					(*this, from, static_cast<const Networking::AddressTcp*>(to)));
 			connection = t.get();
+			connection->setReadPaused(isReadPaused(*connection->getFrom()));
 			mCtx->db.put(std::move(t));
 			// auth
-			Application::get().getMqtt().forceAuth(*buffer, *connection);
+			Application::get().getMqtt().forceAuth(*buffer, offset, *connection);
 		} else {
 			// close expired
 			Application::get().getMqtt().closeOnExpire(&connection);
@@ -179,16 +318,105 @@ void TcpNet::onSend(std::unique_ptr<Networking::Address> from, std::unique_ptr<N
 		}
 		if (connection) {
 			// send
-			*mLog.debug() << UTILS_STR_FUNCTION << ", send-buffer-size: " << buffer->size();
-			*mLog.trace() << UTILS_STR_FUNCTION << ", sent-buffer: " << Utils::putArray(*buffer);
-			connection->send(std::move(buffer));
-			*mLog.debug() << UTILS_STR_FUNCTION << ", push to ID: " << connection->getId();
+			if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+				*mLog.debug() << UTILS_STR_FUNCTION << ", send-buffer-size: " << buffer->size() - offset;
+			}
+			if (mLog.isEnabled(Utils::LoggerLevel::TRACE)) {
+				*mLog.trace() << UTILS_STR_FUNCTION << ", sent-buffer: "
+					<< Utils::putArray(buffer->data() + offset, buffer->size() - offset);
+			}
+			connection->send(std::move(buffer), offset);
+			if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+				*mLog.debug() << UTILS_STR_FUNCTION << ", push to ID: " << connection->getId();
+			}
+			onLatency(time);
 		}
 	} catch (Utils::Error& e) {
 		*mLog.error() << UTILS_STR_FUNCTION << ", error: " << e.what();
 	}
 }
 
+void TcpNet::onLatency(Networking::Time time) {
+	const uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - time).count();
+	TcpNetContext::Latency& latency = mCtx->latency;
+	latency.qty++;
+	latency.sumUs += us;
+	if (us > latency.maxUs) {
+		latency.maxUs = us;
+	}
+	if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+		*mLog.debug() << UTILS_STR_FUNCTION << ", serial-to-tcp-us: " << us;
+	}
+	if (latency.qty >= TCP_NET_LATENCY_REPORT_QTY) {
+		const uint64_t csw = TcpNetContext::getContextSwitches();
+		*mLog.info() << "Serial to TCP latency, mode: " << Utils::Configuration::get().router.mode
+			<< ", samples: " << latency.qty
+			<< ", avg-us: " << latency.sumUs / latency.qty
+			<< ", max-us: " << latency.maxUs
+			<< ", context-switches/msg: " << static_cast<double>(csw - latency.csw) / latency.qty;
+		latency = {0, 0, 0, csw};
+	}
+}
+
+void TcpNet::onPauseRead(const Networking::Address* source, bool isPaused) {
+	if (source->getOrigin() == Networking::Origin::SERIAL) {
+		if (isPaused) {
+			mCtx->readPausedPorts.insert(source);
+		} else {
+			mCtx->readPausedPorts.erase(source);
+		}
+	} else {
+		const uint64_t device = static_cast<const Networking::AddressXBeeNet&>(*source).get();
+		if (isPaused) {
+			mCtx->readPausedDevices.insert(device);
+		} else {
+			mCtx->readPausedDevices.erase(device);
+		}
+	}
+	*mLog.debug() << UTILS_STR_FUNCTION << ", source: " << source->toString()
+		<< ", paused: " << isPaused << ", paused-ports: " << mCtx->readPausedPorts.size()
+		<< ", paused-devices: " << mCtx->readPausedDevices.size();
+	mCtx->db.forEach([this] (TcpNetConnection& connection) {
+		connection.setReadPaused(isReadPaused(*connection.getFrom()));
+	});
+}
+
+void TcpNet::onRoute(const Networking::Address* device, const Networking::Address* port) {
+	*mLog.debug() << UTILS_STR_FUNCTION << ", device: " << device->toString() << ", port: " << port->toString();
+	mCtx->devicePorts[device] = port;
+	mCtx->db.forEach([this, device] (TcpNetConnection& connection) {
+		if (connection.getFrom() == device) {
+			connection.setReadPaused(isReadPaused(*device));
+		}
+	});
+}
+
+void TcpNet::onReset(const Networking::Address* source) {
+	mCtx->db.forEach([this, source] (TcpNetConnection& connection) {
+		if (connection.getFrom() == source && connection.isOpen()) {
+			*mLog.warn() << "Reset, " << source->toString() << " <-> " << connection.getTo()->toString();
+			connection.close();
+		}
+	});
+}
+
+bool TcpNet::isReadPaused(const Networking::Address& device) const {
+	if (device.getOrigin() != Networking::Origin::XBEE) {
+		return false;
+	}
+	if (mCtx->readPausedDevices.count(static_cast<const Networking::AddressXBeeNet&>(device).get())) {
+		return true;
+	}
+	if (mCtx->readPausedPorts.empty()) {
+		return false;
+	}
+	// the device is not routed yet => no downlink data is queued for it
+	std::unordered_map<const Networking::Address*, const Networking::Address*>::const_iterator i =
+			mCtx->devicePorts.find(&device);
+	return i != mCtx->devicePorts.end() && mCtx->readPausedPorts.count(i->second);
+}
+
 ///////////////////// TcpNet::Internal Interface /////////////////////
 boost::asio::io_service& TcpNet::getIo() const {
 	return mCtx->ioService.getIoService();
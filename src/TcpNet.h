@@ -62,9 +62,38 @@ public:
 	 * @param from sender address
 	 * @param to recipient address
 	 * @param buffer data to be sent
+	 * @param offset start of the data in the buffer
+	 * @param time reception time of the data from serial port
 	 */
 	void send(const Networking::Address* from, const Networking::Address* to,
-			std::unique_ptr<Networking::Buffer> buffer) throw ();
+			std::unique_ptr<Networking::Buffer> buffer, std::size_t offset, Networking::Time time) throw ();
+
+	/**
+	 * Pauses or resumes reading from the connections.
+	 * Used as backpressure when the downlink can't accept more data.
+	 *
+	 * @param source serial port address to pause the connections of the devices routed to the port
+	 *               or XBee device address to pause the device connection
+	 * @param isPaused true to stop reading, false to resume
+	 */
+	void pauseRead(const Networking::Address* source, bool isPaused) throw ();
+
+	/**
+	 * Binds the device to the serial port of its coordinator.
+	 * The device connections are paused with the port.
+	 *
+	 * @param device XBee device address
+	 * @param port serial port address
+	 */
+	void route(const Networking::Address* device, const Networking::Address* port) throw ();
+
+	/**
+	 * Closes the connections of the device.
+	 * Used when the data to the device is lost => the session must be restarted.
+	 *
+	 * @param source XBee device address
+	 */
+	void reset(const Networking::Address* source) throw ();
 private:
 	// Objects
 	Utils::Logger				mLog;
@@ -75,8 +104,13 @@ private:
 	TcpNet &operator=(const TcpNet&);
 
 	// Methods
-	void onSend(std::unique_ptr<Networking::Address>, std::unique_ptr<Networking::Address>,
-			std::unique_ptr<Networking::Buffer>);
+	void onSend(const Networking::Address*, const Networking::Address*,
+			std::unique_ptr<Networking::Buffer>, std::size_t, Networking::Time);
+	void onLatency(Networking::Time);
+	void onPauseRead(const Networking::Address*, bool);
+	void onRoute(const Networking::Address*, const Networking::Address*);
+	void onReset(const Networking::Address*);
+	bool isReadPaused(const Networking::Address&) const;
 	bool isMqttConnect(const Networking::Buffer&) const;
 
 	// Internal
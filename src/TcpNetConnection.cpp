@@ -46,8 +46,8 @@ private:
 Utils::IdGen TcpNetConnection::mIdGen;
 
 TcpNetConnection::TcpNetConnection(TcpNet& owner,
-		std::unique_ptr<Networking::Address> from,
-		std::unique_ptr<Networking::AddressTcp> to)
+		const Networking::Address* from,
+		const Networking::AddressTcp* to)
 throw (Utils::Error)
 :
 	mLog(__FUNCTION__),
@@ -55,8 +55,8 @@ throw (Utils::Error)
 	mId(mIdGen.get()),
 	mOwner(owner),
 	mSocket(mOwner.getIo()),
-	mFrom(std::move(from)),
-	mTo(std::move(to))
+	mFrom(from),
+	mTo(to)
 {
 	try {
 		try {
@@ -80,11 +80,13 @@ TcpNetConnection::~TcpNetConnection() {
 	setState(STATE_DESTROYED);
 }
 
-void TcpNetConnection::send(std::unique_ptr<Networking::Buffer> buffer) {
+void TcpNetConnection::send(std::unique_ptr<Networking::Buffer> buffer, std::size_t offset) {
 	std::lock_guard<std::mutex> locker(mMtx);
 	if (!isAlive()) return;
+	// nothing to write
+	if (offset >= buffer->size()) return;
 	try {
-		mWriteQueue.push(std::move(buffer));
+		mWriteQueue.push(std::make_pair(std::move(buffer), offset));
 		if (isWriteReady()) {
 			scheduleWrite();
 		}
@@ -99,6 +101,21 @@ void TcpNetConnection::close() {
 	destroy();
 }
 
+void TcpNetConnection::setReadPaused(bool isPaused) {
+	std::lock_guard<std::mutex> locker(mMtx);
+	if (mIsReadPaused == isPaused) return;
+	*mLog.debug() << UTILS_STR_FUNCTION << ", ID: " << mId << ", paused: " << isPaused;
+	mIsReadPaused = isPaused;
+	try {
+		if (isReadReady()) {
+			scheduleRead();
+		}
+	} catch (Utils::Error& e) {
+		*mLog.error() << UTILS_STR_FUNCTION << ", error: " << e.what();
+		destroy();
+	}
+}
+
 ///////////////////// TcpNetConnection::Internal /////////////////////
 void TcpNetConnection::setState(State v) {
 	mState = v;
@@ -138,6 +155,7 @@ throw (Utils::Error)
 					onRead(a, b);
 				}
 			);
+			mIsReadScheduled = true;
 		} catch (boost::system::system_error e) {
 			throw Utils::Error(e);
 		}
@@ -146,15 +164,17 @@ throw (Utils::Error)
 	}
 }
 
-void TcpNetConnection::scheduleWrite(std::size_t shift)
+void TcpNetConnection::scheduleWrite()
 throw (Utils::Error)
 {
 	if (mWriteQueue.empty()) return;
-	assert(shift<mWriteQueue.front()->size());
+	const Networking::Buffer& data = *mWriteQueue.front().first;
+	const std::size_t shift = mWriteQueue.front().second;
+	assert(shift<data.size());
 	try {
 		try {
 			mSocket.async_write_some(
-				boost::asio::buffer(mWriteQueue.front()->data()+shift, static_cast<std::size_t>(mWriteQueue.front()->size()-shift)),
+				boost::asio::buffer(data.data()+shift, static_cast<std::size_t>(data.size()-shift)),
 				[this](const boost::system::error_code& a, std::size_t b) {
 					onWrite(a, b);
 				}
@@ -201,7 +221,9 @@ void TcpNetConnection::onConnect(const boost::system::error_code& error)
 			scheduleConnect(++mEndPoint);
 		} else {
 			setState(STATE_CONNECTED);
-			scheduleRead();
+			if (!mIsReadPaused) {
+				scheduleRead();
+			}
 			setState(STATE_READING);
 			scheduleWrite();
 		}
@@ -213,23 +235,26 @@ void TcpNetConnection::onConnect(const boost::system::error_code& error)
 
 void TcpNetConnection::onRead(const boost::system::error_code& error, std::size_t qty) {
 	std::lock_guard<std::mutex> locker(mMtx);
+	mIsReadScheduled = false;
 	if (!isAlive()) return;
 	try {
 		if (qty) {
-			*mLog.debug() << UTILS_STR_FUNCTION << ", size: " << qty;
+			if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+				*mLog.debug() << UTILS_STR_FUNCTION << ", size: " << qty;
+			}
 			std::unique_ptr<Networking::Buffer> data
 						(new Networking::Buffer(mBufferRead, mBufferRead+qty));
 			std::unique_ptr<Networking::DataUnit> unit(new Networking::DataUnitTcp(
 					std::move(data),
-					mTo->clone(),	// To -> From
-					mFrom->clone()	// From -> To
+					mTo,	// To -> From
+					mFrom	// From -> To
 			));
 			Application::get().getRouter().process(std::move(unit));
 		}
 		if (error == boost::asio::error::eof || error) {
 			*mLog.error() << UTILS_STR_FUNCTION << ", error: " << error.message();
 			destroy();
-		} else {
+		} else if (!mIsReadPaused) {
 			scheduleRead();
 		}
 	} catch (Utils::Error& e) {
@@ -241,19 +266,19 @@ void TcpNetConnection::onRead(const boost::system::error_code& error, std::size_
 void TcpNetConnection::onWrite(const boost::system::error_code& error, std::size_t qty) {
 	std::lock_guard<std::mutex> locker(mMtx);
 	if (!isAlive()) return;
-	assert(qty<=mWriteQueue.front()->size());
+	assert(mWriteQueue.front().second+qty<=mWriteQueue.front().first->size());
 	try {
 		if (error == boost::asio::error::eof || error) {
 			destroy();
 		} else {
 			setState(STATE_READING);
-			// calculate remaining bytes in current buffer
-			std::size_t shift = mWriteQueue.front()->size()-qty;
-			if (!shift) {
+			// skip the written bytes of current buffer
+			mWriteQueue.front().second += qty;
+			if (mWriteQueue.front().second == mWriteQueue.front().first->size()) {
 				// buffer is fully sent => go to next buffer
 				mWriteQueue.pop();
 			}
-			scheduleWrite(shift);
+			scheduleWrite();
 		}
 	} catch (Utils::Error& e) {
 		*mLog.error() << UTILS_STR_FUNCTION << ", error: " << e.what();
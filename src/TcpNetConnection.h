@@ -23,6 +23,7 @@
 /* System Includes */
 #include <mutex>
 #include <queue>
+#include <utility>
 #include <boost/asio.hpp>
 
 #define TCP_READER_BUFFER_SIZE 512
@@ -41,21 +42,22 @@ namespace TcpNetProtocol {
  */
 class TcpNetConnection {
 public:
-	TcpNetConnection(TcpNet&, std::unique_ptr<Networking::Address>,
-			std::unique_ptr<Networking::AddressTcp>) throw (Utils::Error);
+	TcpNetConnection(TcpNet&, const Networking::Address*,
+			const Networking::AddressTcp*) throw (Utils::Error);
 	~TcpNetConnection();
 
 	Utils::Id getId() const {return mId;}
-	const Networking::Address* getFrom() const {return mFrom.get();}
-	const Networking::AddressTcp* getTo() const {return mTo.get();}
+	const Networking::Address* getFrom() const {return mFrom;}
+	const Networking::AddressTcp* getTo() const {return mTo;}
 	TcpNetProtocol::Type getProtocol() const {return  mProtocol;}
 	uint32_t getExpiration() const {return mExpirationTsSec;}
 
-	void send(std::unique_ptr<Networking::Buffer> buffer);
+	void send(std::unique_ptr<Networking::Buffer> buffer, std::size_t offset = 0);
 	void close();
 	bool isOpen() const {std::lock_guard<std::mutex> locker(mMtx); return isAlive();}
 	void setProtocol(TcpNetProtocol::Type protocol) {mProtocol = protocol;}
 	void setExpiration(uint32_t expirationTsSec) {mExpirationTsSec = expirationTsSec;}
+	void setReadPaused(bool isPaused);
 private:
 	static Utils::IdGen									mIdGen;
 	Utils::Logger										mLog;
@@ -72,23 +74,28 @@ private:
 	TcpNet&												mOwner;
 	boost::asio::ip::tcp::socket							mSocket;
 	boost::asio::ip::tcp::resolver::iterator				mEndPoint;
-	std::unique_ptr<Networking::Address>					mFrom;
-	std::unique_ptr<Networking::AddressTcp>				mTo;
+	const Networking::Address*								mFrom;
+	const Networking::AddressTcp*							mTo;
 	static const std::size_t								mBufferReadSize = TCP_READER_BUFFER_SIZE;
 	uint8_t												mBufferRead[mBufferReadSize];
-	std::queue< std::unique_ptr<Networking::Buffer> >		mWriteQueue;
+	// data and the position of the next byte to write
+	std::queue< std::pair<std::unique_ptr<Networking::Buffer>, std::size_t> >	mWriteQueue;
 	TcpNetProtocol::Type									mProtocol = TcpNetProtocol::UNSET;
 	uint32_t												mExpirationTsSec = 0;
+	// reading is stopped by the downlink backpressure
+	bool													mIsReadPaused = false;
+	bool													mIsReadScheduled = false;
 
 	void setState(State);
 	State getState() const {return mState;}
 	bool isAlive() const {return mState<STATE_DESTROYING;}
 	bool isWriteReady() const {return mState==STATE_READING;}
+	bool isReadReady() const {return mState>=STATE_READING && isAlive() && !mIsReadPaused && !mIsReadScheduled;}
 	void cancel();
 	void destroy();
 	void scheduleConnect(boost::asio::ip::tcp::resolver::iterator) throw (Utils::Error);
 	void scheduleRead() throw (Utils::Error);
-	void scheduleWrite(std::size_t shift = 0) throw (Utils::Error);
+	void scheduleWrite() throw (Utils::Error);
 
 	void onConnect(const boost::system::error_code&);
 	void onRead(const boost::system::error_code&, std::size_t);
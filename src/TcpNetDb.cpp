@@ -37,8 +37,8 @@ TcpNetDb::~TcpNetDb() {
 TcpNetConnection* TcpNetDb::get(const Networking::Address& from, const Networking::Address& to) {
 	for (auto i: mConnections) {
 		if (i->isOpen()
-			&& from.isEqual(*(i->getFrom()))
-			&& to.isEqual(*(i->getTo())))
+			&& &from == i->getFrom()
+			&& &to == i->getTo())
 		{
 			return i;
 		}
@@ -65,6 +65,12 @@ void TcpNetDb::destroy(Utils::Id id) {
 	}
 }
 
+void TcpNetDb::forEach(std::function<void(TcpNetConnection&)> cbk) {
+	for (auto i: mConnections) {
+		cbk(*i);
+	}
+}
+
 ///////////////////// TcpNetDb::Internal /////////////////////
 void TcpNetDb::destroy(TcpNetConnection* connection) {
 	*mLog.debug() << UTILS_STR_FUNCTION << ", Id: " << connection->getId();
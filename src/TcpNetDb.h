@@ -21,6 +21,7 @@
 /* System Includes */
 #include <list>
 #include <memory>
+#include <functional>
 
 
 /* Forward declaration */
@@ -64,6 +65,13 @@ public:
 	 * @param id the connection identifier
 	 */
 	void destroy(Utils::Id id);
+
+	/**
+	 * Calls the function for every connection.
+	 *
+	 * @param cbk the function
+	 */
+	void forEach(std::function<void(TcpNetConnection&)> cbk);
 private:
 	Utils::Logger							mLog;
 	std::list<TcpNetConnection*>			mConnections;
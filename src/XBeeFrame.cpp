@@ -13,519 +13,156 @@
 
 /* Internal Includes */
 #include "XBeeFrame.h"
+#include "XBeeFrameSchema.h"
 /* External Includes */
 /* System Includes */
-
-
-///////////////////// XBeeFrameDelimiter /////////////////////
-XBeeFrameDelimiter::XBeeFrameDelimiter(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		decode(cursor, buffer);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameDelimiter));
-	}
-}
-
-void XBeeFrameDelimiter::decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		if (std::distance(cursor, buffer.end())<1) {
-			throw Utils::Error("Buffer is too short");
+#include <cstring>
+
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define XBEE_FRAME_CHECKSUM_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define XBEE_FRAME_CHECKSUM_NEON
+#endif
+
+///////////////////// Helpers /////////////////////
+/**
+ * 8-bit SUM of bytes.
+ * The sum is modulo 256 => 16 bytes are accumulated in parallel using
+ * wrapping 8-bit lanes and folded at the end.
+ */
+static inline uint8_t sum8(const uint8_t* data, std::size_t size) {
+	uint8_t res = 0;
+	std::size_t i = 0;
+#if defined(XBEE_FRAME_CHECKSUM_SSE2)
+	if (size >= 16) {
+		__m128i acc = _mm_setzero_si128();
+		for (; i + 16 <= size; i += 16) {
+			acc = _mm_add_epi8(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
 		}
-		uint8_t b1 = *(cursor++);
-		if (b1!=VALUE) {
-			throw Utils::Error("Wrong value");
+		// sum of absolute differences with zero => two 64-bit lanes with sums of 8 bytes
+		__m128i lanes = _mm_sad_epu8(acc, _mm_setzero_si128());
+		res = static_cast<uint8_t>(_mm_cvtsi128_si32(lanes) + _mm_cvtsi128_si32(_mm_srli_si128(lanes, 8)));
+	}
+#elif defined(XBEE_FRAME_CHECKSUM_NEON)
+	if (size >= 16) {
+		uint8x16_t acc = vdupq_n_u8(0);
+		for (; i + 16 <= size; i += 16) {
+			acc = vaddq_u8(acc, vld1q_u8(data + i));
 		}
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameDelimiter));
+		uint8x8_t lanes = vadd_u8(vget_low_u8(acc), vget_high_u8(acc));
+		lanes = vpadd_u8(lanes, lanes);
+		lanes = vpadd_u8(lanes, lanes);
+		lanes = vpadd_u8(lanes, lanes);
+		res = vget_lane_u8(lanes, 0);
 	}
-}
-
-void XBeeFrameDelimiter::encode(XBeeBuffer& buffer) {
-	buffer.push_back(getValue());
-}
-
-///////////////////// XBeeFrameLength /////////////////////
-XBeeFrameLength::XBeeFrameLength(type v)
-throw (Utils::Error)
-:
-	mValue(v)
-{
-}
-
-XBeeFrameLength::XBeeFrameLength(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-:
-	mValue(0)
-{
-	try {
-		decode(cursor, buffer);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameLength));
+#endif
+	// tail or scalar fallback
+	for (; i < size; i++) {
+		res += data[i];
 	}
+	return res;
 }
 
-void XBeeFrameLength::decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		if (std::distance(cursor, buffer.end())<2) {
-			throw Utils::Error("Buffer is too short");
+/**
+ * Non-zero if any byte of the word is zero
+ */
+static inline uint64_t hasZeroByte(uint64_t v) {
+	return (v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL;
+}
+
+///////////////////// XBeeFrameEscape /////////////////////
+const uint8_t* XBeeFrameEscape::findControl(const uint8_t* begin, const uint8_t* end) {
+	const uint8_t* p = begin;
+#if defined(XBEE_FRAME_CHECKSUM_SSE2)
+	const __m128i delim = _mm_set1_epi8(static_cast<char>(XBeeFrameDelimiter::VALUE));
+	const __m128i escape = _mm_set1_epi8(static_cast<char>(ESCAPE));
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, delim), _mm_cmpeq_epi8(v, escape)));
+		if (mask) {
+			return p + __builtin_ctz(mask);
 		}
-		uint8_t b1 = *(cursor++);
-		uint8_t b2 = *(cursor++);
-		mValue = ((((uint16_t)b1)<<8) & 0xFF00) | (b2 & 0x00FF);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameLength));
-	}
-}
-
-void XBeeFrameLength::encode(XBeeBuffer& buffer) {
-	buffer.push_back((mValue>>8) & 0x00FF);
-	buffer.push_back(mValue      & 0x00FF);
-}
-
-///////////////////// XBeeFrameApiId /////////////////////
-XBeeFrameApiId::XBeeFrameApiId(type v)
-throw (Utils::Error)
-:
-	mValue(v)
-{
-	try {
-		check();
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameApiId));
 	}
-}
-
-XBeeFrameApiId::XBeeFrameApiId(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		decode(cursor, buffer);
-		check();
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameApiId));
-	}
-}
-
-void XBeeFrameApiId::check()
-throw (Utils::Error)
-{
-	try {
-		switch(mValue) {
-			case ZB_TX_REQ:
-			case ZB_RX_RSP:
-				break;
-			default:
-				throw Utils::Error("Not implemented");
+#else
+	const uint64_t delim = 0x0101010101010101ULL * XBeeFrameDelimiter::VALUE;
+	const uint64_t escape = 0x0101010101010101ULL * ESCAPE;
+	for (; end - p >= 8; p += 8) {
+		uint64_t v;
+		std::memcpy(&v, p, sizeof(v));
+		if (hasZeroByte(v ^ delim) | hasZeroByte(v ^ escape)) {
+			// exact position is resolved by the tail loop
+			break;
 		}
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameApiId));
 	}
-}
-
-void XBeeFrameApiId::decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		if (std::distance(cursor, buffer.end())<1) {
-			throw Utils::Error("Buffer is too short");
+#endif
+	// tail or exact position
+	for (; p < end; p++) {
+		if (*p == XBeeFrameDelimiter::VALUE || *p == ESCAPE) {
+			break;
 		}
-		mValue = (type) (*(cursor++));
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameApiId));
 	}
+	return p;
 }
 
-void XBeeFrameApiId::encode(XBeeBuffer& buffer) {
-	buffer.push_back(mValue);
-}
-
-///////////////////// XBeeFrameId /////////////////////
-XBeeFrameId::XBeeFrameId(type v)
-throw (Utils::Error)
-:
-	mValue(v)
-{
-}
-
-XBeeFrameId::XBeeFrameId(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		decode(cursor, buffer);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameId));
-	}
+///////////////////// XBeeFrameChecksum /////////////////////
+uint8_t XBeeFrameChecksum::sum(const uint8_t* data, std::size_t size) {
+	return sum8(data, size);
 }
 
-void XBeeFrameId::decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		if (std::distance(cursor, buffer.end())<1) {
-			throw Utils::Error("Buffer is too short");
-		}
-		mValue = (type) (*(cursor++));
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameId));
-	}
+XBeeFrameChecksum::type XBeeFrameChecksum::calculate(const uint8_t* data, std::size_t size) {
+	return 0xFF - sum8(data, size);
 }
 
-void XBeeFrameId::encode(XBeeBuffer& buffer) {
-	buffer.push_back(mValue);
+bool XBeeFrameChecksum::isValid(const uint8_t* data, std::size_t size) {
+	return sum8(data, size) == 0xFF;
 }
 
-///////////////////// XBeeFrameAddr64 /////////////////////
-XBeeFrameAddr64::XBeeFrameAddr64(type v)
-throw (Utils::Error)
+///////////////////// XBeeFrameView /////////////////////
+XBeeFrameView::XBeeFrameView()
 :
-	mValue(v)
+	mFrame(nullptr),
+	mApiId(XBeeFrameApiId::ZB_RX_RSP),
+	mDataOffset(0),
+	mDataSize(0)
 {
 }
 
-XBeeFrameAddr64::XBeeFrameAddr64(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-:
-	mValue(0)
+XBeeFrameStatus::Type XBeeFrameView::decode(const XBeeBuffer& frame)
+throw ()
 {
-	try {
-		decode(cursor, buffer);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameAddr64));
+	mFrame = &frame;
+	const uint8_t* p = frame.data();
+	const XBeeBuffer::size_type size = frame.size();
+	// Delimiter + Length
+	if (size < XBEE_FRAME_HEADER_SIZE) {
+		return XBeeFrameStatus::TOO_SHORT;
 	}
-}
-
-void XBeeFrameAddr64::decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		if (std::distance(cursor, buffer.end())<8) {
-			throw Utils::Error("Buffer is too short");
-		}
-		uint8_t b1 = *(cursor++);
-		uint8_t b2 = *(cursor++);
-		uint8_t b3 = *(cursor++);
-		uint8_t b4 = *(cursor++);
-		uint8_t b5 = *(cursor++);
-		uint8_t b6 = *(cursor++);
-		uint8_t b7 = *(cursor++);
-		uint8_t b8 = *(cursor++);
-		mValue =
-		((((uint64_t)b1)<<56) & 0xFF00000000000000) |
-		((((uint64_t)b2)<<48) & 0x00FF000000000000) |
-		((((uint64_t)b3)<<40) & 0x0000FF0000000000) |
-		((((uint64_t)b4)<<32) & 0x000000FF00000000) |
-		((((uint64_t)b5)<<24) & 0x00000000FF000000) |
-		((((uint64_t)b6)<<16) & 0x0000000000FF0000) |
-		((((uint64_t)b7)<< 8) & 0x000000000000FF00) |
-		((((uint64_t)b8)    ) & 0x00000000000000FF)
-		;
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameAddr64));
+	if (p[0] != XBeeFrameDelimiter::VALUE) {
+		return XBeeFrameStatus::WRONG_DELIMITER;
 	}
-}
-
-void XBeeFrameAddr64::encode(XBeeBuffer& buffer) {
-	buffer.push_back((mValue>>56) & 0xFF);
-	buffer.push_back((mValue>>48) & 0xFF);
-	buffer.push_back((mValue>>40) & 0xFF);
-	buffer.push_back((mValue>>32) & 0xFF);
-	buffer.push_back((mValue>>24) & 0xFF);
-	buffer.push_back((mValue>>16) & 0xFF);
-	buffer.push_back((mValue>> 8) & 0xFF);
-	buffer.push_back((mValue    ) & 0xFF);
-}
-
-///////////////////// XBeeFrameAddr16 /////////////////////
-XBeeFrameAddr16::XBeeFrameAddr16(type v)
-throw (Utils::Error)
-:
-	mValue(v)
-{
-}
-
-XBeeFrameAddr16::XBeeFrameAddr16(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-:
-	mValue(0)
-{
-	try {
-		decode(cursor, buffer);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameAddr16));
+	const XBeeFrameSchema::Length::type length = XBeeFrameSchema::Length::decode(p+1);
+	if (size < static_cast<XBeeBuffer::size_type>(XBEE_FRAME_HEADER_SIZE + length + XBEE_FRAME_CHECKSUM_SIZE)) {
+		return XBeeFrameStatus::TOO_SHORT;
 	}
-}
-
-void XBeeFrameAddr16::decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		if (std::distance(cursor, buffer.end())<2) {
-			throw Utils::Error("Buffer is too short");
-		}
-		uint8_t b1 = *(cursor++);
-		uint8_t b2 = *(cursor++);
-		mValue =
-		((((uint16_t)b1)<<8) & 0xFF00) |
-		((((uint16_t)b2)   ) & 0x00FF)
-		;
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameAddr16));
+	// API Id
+	if (length < 1) {
+		return XBeeFrameStatus::WRONG_LENGTH;
 	}
-}
-
-void XBeeFrameAddr16::encode(XBeeBuffer& buffer) {
-	buffer.push_back((mValue>> 8) & 0xFF);
-	buffer.push_back((mValue    ) & 0xFF);
-}
-
-///////////////////// XBeeFrameOptions /////////////////////
-XBeeFrameOptions::XBeeFrameOptions()
-throw (Utils::Error)
-:
-	mValue(0)
-{
-}
-
-XBeeFrameOptions::XBeeFrameOptions(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-:
-	mValue(0)
-{
-	try {
-		decode(cursor, buffer);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameOptions));
-	}
-}
-
-void XBeeFrameOptions::decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		if (std::distance(cursor, buffer.end())<1) {
-			throw Utils::Error("Buffer is too short");
-		}
-		mValue = *(cursor++);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameOptions));
+	const uint8_t apiId = p[XBEE_FRAME_HEADER_SIZE];
+	// API Data
+	const XBeeFrameSchema::Frames& frames = XBeeFrameSchema::Frames::get();
+	if (!frames.isKnown(apiId)) {
+		return XBeeFrameStatus::NOT_IMPLEMENTED;
 	}
-}
-
-void XBeeFrameOptions::encode(XBeeBuffer& buffer) {
-	buffer.push_back(mValue);
-}
-
-///////////////////// XBeeFrameRadius /////////////////////
-XBeeFrameRadius::XBeeFrameRadius(type v)
-throw (Utils::Error)
-:
-	mValue(v)
-{
-}
-
-XBeeFrameRadius::XBeeFrameRadius(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		decode(cursor, buffer);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameRadius));
-	}
-}
-
-void XBeeFrameRadius::decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		if (std::distance(cursor, buffer.end())<1) {
-			throw Utils::Error("Buffer is too short");
-		}
-		mValue = (type) (*(cursor++));
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameRadius));
-	}
-}
-
-void XBeeFrameRadius::encode(XBeeBuffer& buffer) {
-	buffer.push_back(mValue);
-}
-
-///////////////////// XBeeFrameData /////////////////////
-XBeeFrameData::XBeeFrameData(std::unique_ptr<XBeeBuffer> buffer)
-{
-	mValue = std::move(*buffer);
-}
-
-XBeeFrameData::XBeeFrameData(XBeeBuffer::const_iterator begin, XBeeBuffer::const_iterator end)
-{
-	mValue.assign(begin, end);
-}
-
-XBeeFrameData::XBeeFrameData(XBeeBuffer::const_iterator& cursor, XBeeFrameLength::type length, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		decode(cursor, length, buffer);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameData));
-	}
-}
-
-void XBeeFrameData::decode(XBeeBuffer::const_iterator& cursor, XBeeFrameLength::type length, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		if (std::distance(cursor, buffer.end())<length) {
-			throw Utils::Error("Buffer is too short");
-		}
-		auto begin = cursor;
-		cursor += length;
-		mValue.assign(begin, cursor);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrameData));
-	}
-}
-
-void XBeeFrameData::encode(XBeeBuffer& buffer) {
-	buffer.insert(buffer.end(), mValue.begin(), mValue.end());
-}
-
-///////////////////// XBeeFrame /////////////////////
-XBeeFrame::XBeeFrame(std::unique_ptr<XBeeFrameApiId> apiId)
-:
-	mDelimiter(new XBeeFrameDelimiter),
-	mApiId(std::move(apiId))
-{
-}
-
-XBeeFrame::XBeeFrame(const XBeeBuffer& frame)
-throw (Utils::Error)
-{
-	try {
-		XBeeBuffer::const_iterator begin(frame.begin());
-		decode(begin, frame);
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrame));
-	}
-}
-
-void XBeeFrame::decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		// Delimiter
-		mDelimiter.reset(new XBeeFrameDelimiter(cursor, buffer));
-		// Length
-		mLength.reset(new XBeeFrameLength(cursor, buffer));
-		// Save cursor place
-		auto paylodStart = cursor;
-		// API Id
-		mApiId.reset(new XBeeFrameApiId(cursor, buffer));
-		// API Data
-		switch(mApiId->getValue()) {
-			case XBeeFrameApiId::ZB_RX_RSP:
-			{
-				// Source Address 64
-				mAddr64Src.reset(new XBeeFrameAddr64Src(cursor, buffer));
-				// Source Address 16
-				mAddr16Src.reset(new XBeeFrameAddr16Src(cursor, buffer));
-				// Options
-				mOptionsRecv.reset(new XBeeFrameOptionsRecv(cursor, buffer));
-				// Calculate bytes till this point
-				uint16_t bytesQty = std::distance(paylodStart, cursor);
-				if (mLength->getValue() < bytesQty) {
-					throw Utils::Error("Length value is less than must be");
-				}
-				// Data
-				mData.reset(new XBeeFrameData(cursor, mLength->getValue()-bytesQty, buffer));
-			}
-				break;
-			default:
-				throw Utils::Error("API is not implemented");
-		}
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrame));
-	}
-}
-
-void XBeeFrame::encode(XBeeBuffer& buffer)
-throw (Utils::Error)
-{
-	try {
-		uint16_t checkSumStartPoint = 0;
-		buffer.clear();
-		// Delimiter
-		checkNull(mDelimiter.get(), "Delimiter");
-		mDelimiter->encode(buffer);
-		// Skip Length temporary
-		// Save the point
-		uint16_t lengthStartPoint = buffer.size();
-		// API Id
-		checkNull(mApiId.get(), "ApiId");
-		mApiId->encode(buffer);
-		// API Data
-		switch (mApiId->getValue()) {
-			case XBeeFrameApiId::ZB_TX_REQ:
-			{
-				// Frame Id
-				checkNull(mId.get(), "Id");
-				mId->encode(buffer);
-				// Destination Address 64
-				checkNull(mAddr64Dst.get(), "Addr64Dst");
-				mAddr64Dst->encode(buffer);
-				// Destination Address 16
-				checkNull(mAddr16Dst.get(), "Addr16Dst");
-				mAddr16Dst->encode(buffer);
-				// Radius
-				checkNull(mRadius.get(), "Radius");
-				mRadius->encode(buffer);
-				// Options
-				checkNull(mOptionsSend.get(), "OptionsSend");
-				mOptionsSend->encode(buffer);
-				// Data
-				checkNull(mData.get(), "Data");
-				mData->encode(buffer);
-			}
-				break;
-			default:
-				throw Utils::Error("API is not implemented");
-		}
-		// Length
-		{
-			XBeeBuffer tmp;
-			XBeeFrameLength length(buffer.size()-lengthStartPoint);
-			length.encode(tmp);
-			// update checksum starting point => after length
-			checkSumStartPoint=lengthStartPoint+tmp.size();
-			// insert
-			buffer.insert(buffer.begin()+lengthStartPoint, tmp.begin(), tmp.end());
-		}
-		// Checksum
-		// 0xFF minus 8-bit SUM of bytes between the length and checksum fields
-		{
-			uint8_t checksum = 0;
-			for(auto it = (buffer.begin()+checkSumStartPoint); it!=buffer.end(); it++) {
-				checksum += (*it);
-			}
-			checksum = 0xFF - checksum;
-			// insert
-			buffer.push_back(checksum);
-		}
-	} catch (Utils::Error& e) {
-		throw Utils::Error(e, UTILS_STR_CLASS_FUNCTION(XBeeFrame));
-	}
-}
-
-void XBeeFrame::checkNull(void* v, const std::string& name)
-throw (Utils::Error)
-{
-	if (!v) {
-		throw Utils::Error(name + "is not available");
+	const std::size_t fixedSize = frames.getFixedSize(apiId);
+	if (length < fixedSize) {
+		return XBeeFrameStatus::WRONG_LENGTH;
 	}
+	mApiId = static_cast<XBeeFrameApiId::type>(apiId);
+	mDataOffset = XBEE_FRAME_HEADER_SIZE + fixedSize;
+	mDataSize = length - fixedSize;
+	return XBeeFrameStatus::OK;
 }
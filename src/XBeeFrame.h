@@ -15,184 +15,120 @@
 #define XBEE_FRAME_H_
 
 /* Internal Includes */
-#include "Error.h"
 /* External Includes */
 /* System Includes */
 #include <stdint.h>
+#include <cstddef>
 #include <vector>
-#include <memory>
+#include <assert.h>
 
-#define XBEE_FRAME_LENGTH_MAX 512
+#define XBEE_FRAME_LENGTH_MAX				512
+#define XBEE_FRAME_HEADER_SIZE				3	// Delimiter + 16-bit Length
+#define XBEE_FRAME_CHECKSUM_SIZE			1
 
 typedef std::vector<uint8_t> XBeeBuffer;
 
-class XBeeFrameDelimiter {
-public:
-	typedef uint8_t type;
-	static const type VALUE = 0x7E;
-
-	XBeeFrameDelimiter() {}
-	XBeeFrameDelimiter(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
-	void encode(XBeeBuffer&);
-	type getValue() const { return VALUE; }
-private:
-	void decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
+/**
+ * Result of the frame decoding/encoding.
+ * The frame processing is a hot path => errors are reported by value.
+ */
+struct XBeeFrameStatus {
+	typedef enum {
+		OK,
+		TOO_SHORT,
+		WRONG_DELIMITER,
+		WRONG_LENGTH,
+		NOT_IMPLEMENTED,
+		NOT_AVAILABLE,
+		QTY
+	} Type;
+
+	static const char* toString(Type v) {
+		switch (v) {
+			case OK:				return "OK";
+			case TOO_SHORT:			return "Buffer is too short";
+			case WRONG_DELIMITER:	return "Wrong delimiter";
+			case WRONG_LENGTH:		return "Length value is less than must be";
+			case NOT_IMPLEMENTED:	return "API is not implemented";
+			case NOT_AVAILABLE:		return "Field is not available";
+			default:				return "UNKNW";
+		}
+	}
 };
 
-class XBeeFrameLength {
-public:
-	typedef uint16_t type;
-
-	XBeeFrameLength(type) throw (Utils::Error);
-	XBeeFrameLength(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
-	void encode(XBeeBuffer&);
-	type getValue() const { return mValue; }
-private:
-	type		mValue;
+/**
+ * API operation mode (AP parameter)
+ */
+struct XBeeFrameApiMode {
+	typedef enum {
+		UNESCAPED	= 1,	// API mode 1, frames are delimited by the length only
+		ESCAPED		= 2,	// API mode 2, control bytes in frame are escaped
+	} Type;
+};
 
-	void decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
+struct XBeeFrameDelimiter {
+	typedef uint8_t type;
+	static const type VALUE = 0x7E;
 };
 
-class XBeeFrameApiId {
-public:
+struct XBeeFrameApiId {
 	enum type {
+		AT_CMD				= 0x08,
 		ZB_TX_REQ			= 0x10,
+		AT_CMD_RSP			= 0x88,
+		MODEM_STATUS		= 0x8A,
+		ZB_TX_STATUS		= 0x8B,
 		ZB_RX_RSP			= 0x90,
+		ZB_EXPLICIT_RX_RSP	= 0x91,
+		ZB_IO_SAMPLE_RSP	= 0x92,
+		ZB_NODE_ID_RSP		= 0x95,
+		ZB_ROUTE_RECORD		= 0xA1,
 	};
-
-	XBeeFrameApiId(type) throw (Utils::Error);
-	XBeeFrameApiId(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
-	void encode(XBeeBuffer&);
-	type getValue() const { return mValue; }
-private:
-	type		mValue;
-
-	void check() throw (Utils::Error);
-	void decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
 };
 
-class XBeeFrameId {
-public:
+struct XBeeFrameId {
 	typedef uint8_t type;
 	static const type NO_RSP = 0; // no response is requested
-
-	XBeeFrameId(type) throw (Utils::Error);
-	XBeeFrameId(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
-	void encode(XBeeBuffer&);
-	type getValue() const { return mValue; }
-private:
-	type		mValue;
-
-	void decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
 };
 
-class XBeeFrameAddr64 {
-public:
+struct XBeeFrameAddr64 {
 	typedef uint64_t type;
-
-	XBeeFrameAddr64(type) throw (Utils::Error);
-	XBeeFrameAddr64(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
-	void encode(XBeeBuffer&);
-	type getValue() const { return mValue; }
-private:
-	type		mValue;
-
-	void decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
 };
 
-class XBeeFrameAddr64Src: public XBeeFrameAddr64 {
-public:
+struct XBeeFrameAddr64Src: public XBeeFrameAddr64 {
 	static const type UNKNOWN = 0xFFFFFFFFFFFFFFFF;
-
-	XBeeFrameAddr64Src(type v) throw (Utils::Error)
-		:XBeeFrameAddr64(v) {}
-	XBeeFrameAddr64Src(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer) throw (Utils::Error)
-		:XBeeFrameAddr64(cursor, buffer) {}
 };
 
-class XBeeFrameAddr64Dst: public XBeeFrameAddr64 {
-public:
+struct XBeeFrameAddr64Dst: public XBeeFrameAddr64 {
 	static const type COORDINATOR = 0x0000000000000000;
 	static const type BROADCAST = 0x000000000000FFFF;
-
-	XBeeFrameAddr64Dst(type v) throw (Utils::Error)
-		:XBeeFrameAddr64(v) {}
-	XBeeFrameAddr64Dst(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer) throw (Utils::Error)
-		:XBeeFrameAddr64(cursor, buffer) {}
 };
 
-class XBeeFrameAddr16 {
-public:
+struct XBeeFrameAddr16 {
 	typedef uint16_t type;
 	static const type UNKNOWN = 0xFFFE; // address is unknown
-
-	XBeeFrameAddr16(type) throw (Utils::Error);
-	XBeeFrameAddr16(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
-	void encode(XBeeBuffer&);
-	type getValue() const { return mValue; }
-private:
-	type		mValue;
-
-	void decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
 };
 
-class XBeeFrameAddr16Src: public XBeeFrameAddr16 {
-public:
-	XBeeFrameAddr16Src(type v) throw (Utils::Error)
-		:XBeeFrameAddr16(v) {}
-	XBeeFrameAddr16Src(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer) throw (Utils::Error)
-		:XBeeFrameAddr16(cursor, buffer) {}
+struct XBeeFrameAddr16Src: public XBeeFrameAddr16 {
 };
 
-class XBeeFrameAddr16Dst: public XBeeFrameAddr16 {
-public:
+struct XBeeFrameAddr16Dst: public XBeeFrameAddr16 {
 	static const type TO_ALL_ROUTERS = 0xFFFC; // broadcast to all routers
 	static const type TO_ALL_NON_SLEPPY = 0xFFFD; // broadcast to all non-sleepy devices;
 	static const type BROADCAST = 0xFFFF; // broadcast to all devices including sleepy ED.
-
-	XBeeFrameAddr16Dst(type v) throw (Utils::Error)
-		:XBeeFrameAddr16(v) {}
-	XBeeFrameAddr16Dst(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer) throw (Utils::Error)
-		:XBeeFrameAddr16(cursor, buffer) {}
 };
 
-class XBeeFrameOptions {
-public:
-	void encode(XBeeBuffer&);
-protected:
+struct XBeeFrameOptionsRecv {
 	typedef uint8_t type;
-	void set(type v) { mValue |= v; }
-	void unset(type v) { mValue &= (~v); }
-	bool isSet(type v) const { return mValue & v; }
-
-	XBeeFrameOptions() throw (Utils::Error);
-	XBeeFrameOptions(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
-private:
-	type		mValue;
-
-	void decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
-};
-
-class XBeeFrameOptionsRecv: public XBeeFrameOptions {
-public:
 	enum bit {
 		PKT_ACKED			= 0x01, // Packet Acknowledged
 		PKT_BROADCAST		= 0x02, // Packet was a broadcast packet
 		PKT_ENCRYPTED_APS	= 0x20, // Packet encrypted with APS encryption
 		PKT_FROM_ENDDEV		= 0x40, // Packet was sent from an end device (if known)
 	};
-	void set(bit v) { XBeeFrameOptions::set(v); }
-	void unset(bit v) { XBeeFrameOptions::unset(v); }
-	bool isSet(bit v) const { return XBeeFrameOptions::isSet(v); }
-
-	XBeeFrameOptionsRecv() throw (Utils::Error) {}
-	XBeeFrameOptionsRecv(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer) throw (Utils::Error)
-			:XBeeFrameOptions(cursor, buffer) {}
-private:
 };
 
-class XBeeFrameOptionsSend: public XBeeFrameOptions {
-public:
+struct XBeeFrameOptionsSend {
 	typedef uint8_t type;
 	enum bit {
 		DISABLE_RETRIES_REPAIR	= 0x01, // Disable retries and route repair
@@ -201,97 +137,159 @@ public:
 										// of RF payload bytes by 4 (below the value reported by NP).
 		USE_EXTENDED_TX_TIMEOUT	= 0x40, // Use the extended transmission timeout for this destination
 	};
-	void set(bit v) { XBeeFrameOptions::set(v); }
-	void unset(bit v) { XBeeFrameOptions::unset(v); }
-	bool isSet(bit v) const { return XBeeFrameOptions::isSet(v); }
+};
 
-	XBeeFrameOptionsSend() throw (Utils::Error) {}
-	XBeeFrameOptionsSend(XBeeBuffer::const_iterator& cursor, const XBeeBuffer& buffer) throw (Utils::Error)
-			:XBeeFrameOptions(cursor, buffer) {}
-private:
+/**
+ * API mode 2 escaping
+ */
+struct XBeeFrameEscape {
+	static const uint8_t ESCAPE = 0x7D;
+	static const uint8_t XON = 0x11;
+	static const uint8_t XOFF = 0x13;
+
+	static bool isNeeded(uint8_t b) {
+		return b == XBeeFrameDelimiter::VALUE || b == ESCAPE || b == XON || b == XOFF;
+	}
+	static uint8_t apply(uint8_t b) { return b ^ 0x20; }
+
+	/**
+	 * Finds the first delimiter or escape byte
+	 *
+	 * @return pointer to the found byte or 'end'
+	 */
+	static const uint8_t* findControl(const uint8_t* begin, const uint8_t* end);
 };
 
-class XBeeFrameRadius {
-public:
+struct XBeeFrameModemStatus {
 	typedef uint8_t type;
-	static const type MAX = 0; // the network maximum hops value will be used
+	static const type HW_RESET = 0x00;
+	static const type WDT_RESET = 0x01;
+};
 
-	XBeeFrameRadius(type) throw (Utils::Error);
-	XBeeFrameRadius(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
-	void encode(XBeeBuffer&);
-	type getValue() const { return mValue; }
-private:
-	type		mValue;
+struct XBeeFrameDeliveryStatus {
+	typedef uint8_t type;
+	static const type SUCCESS = 0x00;
+	static const type ADDRESS_NOT_FOUND = 0x24;
+	static const type ROUTE_NOT_FOUND = 0x25;
+};
 
-	void decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
+struct XBeeFrameAtCommand {
+	typedef uint16_t type;
+	static const type NP = 0x4E50; // maximum RF payload bytes
+	static const type BD = 0x4244; // interface data rate
 };
 
-class XBeeFrameData {
-public:
-	XBeeFrameData(std::unique_ptr<XBeeBuffer>);
-	XBeeFrameData(XBeeBuffer::const_iterator begin, XBeeBuffer::const_iterator end);
-	XBeeFrameData(XBeeBuffer::const_iterator& cursor, XBeeFrameLength::type length, const XBeeBuffer&) throw (Utils::Error);
-	void encode(XBeeBuffer&);
-	const XBeeBuffer& getValue() const { return mValue; }
-private:
-	XBeeBuffer		mValue;
+/**
+ * Standard rates of the BD parameter
+ */
+struct XBeeFrameBaudRate {
+	typedef uint8_t type;
 
-	void decode(XBeeBuffer::const_iterator& cursor, XBeeFrameLength::type length, const XBeeBuffer&) throw (Utils::Error);
+	/**
+	 * Gets the BD parameter value
+	 *
+	 * @return false if the rate is not a standard one
+	 */
+	static bool toCode(uint32_t baud, type& code) {
+		static const uint32_t rates[] = {
+			1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600
+		};
+		for (type i = 0; i < sizeof(rates)/sizeof(rates[0]); i++) {
+			if (rates[i] == baud) {
+				code = i;
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+struct XBeeFrameAtStatus {
+	typedef uint8_t type;
+	static const type OK = 0x00;
+};
+
+struct XBeeFrameRadius {
+	typedef uint8_t type;
+	static const type MAX = 0; // the network maximum hops value will be used
+};
+
+struct XBeeFrameChecksum {
+	typedef uint8_t type;
+
+	/**
+	 * Calculates 8-bit SUM of bytes
+	 */
+	static uint8_t sum(const uint8_t* data, std::size_t size);
+
+	/**
+	 * Calculates the checksum.
+	 * 0xFF minus 8-bit SUM of bytes between the length and checksum fields
+	 *
+	 * @param data first byte after the length field
+	 * @param size number of bytes till the checksum field
+	 */
+	static type calculate(const uint8_t* data, std::size_t size);
+
+	/**
+	 * Verifies the checksum.
+	 * 8-bit SUM of bytes between the length and checksum fields including
+	 * the checksum must be equal to 0xFF
+	 *
+	 * @param data first byte after the length field
+	 * @param size number of bytes including the checksum field
+	 */
+	static bool isValid(const uint8_t* data, std::size_t size);
 };
 
 /**
- * XBee network frame
+ * Non-owning XBee network frame decoder.
+ * Validates the frame in place and gives access to the fields without
+ * allocations and copying. The buffer must outlive the view.
+ * Fields are accessed through the frame layouts from XBeeFrameSchema.h.
  */
-class XBeeFrame {
+class XBeeFrameView {
 public:
 	/**
 	 * Constructor
-	 *
-	 * @param apiId XBee network Frame API Id
 	 */
-	XBeeFrame(std::unique_ptr<XBeeFrameApiId> apiId);
+	XBeeFrameView();
 
 	/**
-	 * Constructor
+	 * Decodes the frame
 	 *
-	 * @param buffer XBee network buffer in API 2 mode
+	 * @param frame XBee network frame with removed escapes
+	 * @return status of the decoding; getters are valid only on success
 	 */
-	XBeeFrame(const XBeeBuffer& frame) throw (Utils::Error);
+	XBeeFrameStatus::Type decode(const XBeeBuffer& frame) throw ();
 
+	// Getters
+	XBeeFrameApiId::type getApiId() const { return mApiId; }
 	/**
-	 * Encodes the XBee network Frame to the given buffer
+	 * Field value
+	 *
+	 * Usage: view.get<XBeeFrameSchema::ZbRxRsp, XBeeFrameSchema::Addr64>()
 	 */
-	void encode(XBeeBuffer&) throw (Utils::Error);
-
-	// Getters
-	const XBeeFrameApiId* getApiId() const { return mApiId.get(); }
-	const XBeeFrameAddr64Src* getAddr64Src() const { return mAddr64Src.get(); }
-	const XBeeFrameAddr16Src* getAddr16Src() const { return mAddr16Src.get(); }
-	const XBeeFrameData* getData() const { return mData.get(); }
-	// Setters
-	void setId(std::unique_ptr<XBeeFrameId> v) { mId = std::move(v); }
-	void setRadius(std::unique_ptr<XBeeFrameRadius> v) { mRadius = std::move(v); }
-	void setAddr64Dst(std::unique_ptr<XBeeFrameAddr64Dst> v) { mAddr64Dst = std::move(v); }
-	void setAddr16Dst(std::unique_ptr<XBeeFrameAddr16Dst> v) { mAddr16Dst = std::move(v); }
-	void setOptionsSend(std::unique_ptr<XBeeFrameOptionsSend> v) { mOptionsSend = std::move(v); }
-	void setData(std::unique_ptr<XBeeFrameData> v) { mData = std::move(v); }
-
+	template<typename tFrame, typename tField>
+	typename tField::type get() const {
+		assert(tFrame::API_ID == mApiId);
+		return tFrame::template get<tField>(mFrame->data() + XBEE_FRAME_HEADER_SIZE);
+	}
+	/**
+	 * Payload span inside the frame buffer
+	 */
+	const uint8_t* getData() const { return mFrame->data() + mDataOffset; }
+	XBeeBuffer::size_type getDataOffset() const { return mDataOffset; }
+	XBeeBuffer::size_type getDataSize() const { return mDataSize; }
 private:
-	std::unique_ptr<XBeeFrameDelimiter>				mDelimiter;
-	std::unique_ptr<XBeeFrameLength>				mLength;
-	std::unique_ptr<XBeeFrameApiId>					mApiId;
-	std::unique_ptr<XBeeFrameId>					mId;
-	std::unique_ptr<XBeeFrameRadius>				mRadius;
-	std::unique_ptr<XBeeFrameAddr64Src>				mAddr64Src;
-	std::unique_ptr<XBeeFrameAddr16Src>				mAddr16Src;
-	std::unique_ptr<XBeeFrameOptionsRecv>			mOptionsRecv;
-	std::unique_ptr<XBeeFrameAddr64Dst>				mAddr64Dst;
-	std::unique_ptr<XBeeFrameAddr16Dst>				mAddr16Dst;
-	std::unique_ptr<XBeeFrameOptionsSend>			mOptionsSend;
-	std::unique_ptr<XBeeFrameData>					mData;
-
-	void decode(XBeeBuffer::const_iterator& cursor, const XBeeBuffer&) throw (Utils::Error);
-	void checkNull(void*, const std::string& name) throw (Utils::Error);
+	const XBeeBuffer*								mFrame;
+	XBeeFrameApiId::type							mApiId;
+	XBeeBuffer::size_type							mDataOffset;
+	XBeeBuffer::size_type							mDataSize;
+
+	// Do not copy
+	XBeeFrameView(const XBeeFrameView&);
+	XBeeFrameView &operator=(const XBeeFrameView&);
 };
 
 #endif /* XBEE_FRAME_H_ */
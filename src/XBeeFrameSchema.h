@@ -0,0 +1,328 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: XBee network Frame. Declarative layouts of the API frames.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef XBEE_FRAME_SCHEMA_H_
+#define XBEE_FRAME_SCHEMA_H_
+
+/* Internal Includes */
+#include "XBeeFrame.h"
+/* External Includes */
+/* System Includes */
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+
+
+/**
+ * Every API frame is described once as a list of fixed size fields following
+ * the API Id. The optional variable size tail (RF data, AT parameter, etc.)
+ * follows the fixed part. Offsets, sizes, accessors and the encoder are
+ * generated at compile time from the list.
+ *
+ * Adding a frame type:
+ *  - describe the layout with 'Frame<API_ID, Fields...>'
+ *  - add it to the 'Frames' table
+ *  - specialize the handler of the 'Frames::Dispatcher' if the frame has a consumer
+ */
+namespace XBeeFrameSchema {
+
+///////////////////// Fields /////////////////////
+/**
+ * Big-endian field of the fixed size
+ */
+template<typename tType, std::size_t tSize> struct Field {
+	typedef tType type;
+	static const std::size_t SIZE = tSize;
+
+	static type decode(const uint8_t* p) {
+		uint64_t res = 0;
+		for (std::size_t i = 0; i < SIZE; i++) {
+			res = (res<<8) | p[i];
+		}
+		return static_cast<type>(res);
+	}
+
+	template<typename tWriter>
+	static void write(tWriter& w, type v) {
+		for (std::size_t i = SIZE; i > 0; i--) {
+			w.put(static_cast<uint8_t>((static_cast<uint64_t>(v) >> (8*(i-1))) & 0xFF));
+		}
+	}
+};
+
+struct Length:				Field<uint16_t, 2> {};
+struct FrameId:				Field<XBeeFrameId::type, 1> {};
+struct Addr64:				Field<XBeeFrameAddr64::type, 8> {};
+struct Addr16:				Field<XBeeFrameAddr16::type, 2> {};
+struct Radius:				Field<XBeeFrameRadius::type, 1> {};
+struct Options:				Field<uint8_t, 1> {};
+struct AtCommand:			Field<uint16_t, 2> {};
+struct AtStatus:			Field<uint8_t, 1> {};
+struct ModemStatus:			Field<uint8_t, 1> {};
+struct TxRetryCount:		Field<uint8_t, 1> {};
+struct DeliveryStatus:		Field<uint8_t, 1> {};
+struct DiscoveryStatus:		Field<uint8_t, 1> {};
+struct SrcEndpoint:			Field<uint8_t, 1> {};
+struct DstEndpoint:			Field<uint8_t, 1> {};
+struct ClusterId:			Field<uint16_t, 2> {};
+struct ProfileId:			Field<uint16_t, 2> {};
+struct SamplesQty:			Field<uint8_t, 1> {};
+struct DigitalMask:			Field<uint16_t, 2> {};
+struct AnalogMask:			Field<uint8_t, 1> {};
+struct AddressesQty:		Field<uint8_t, 1> {};
+
+///////////////////// Writers /////////////////////
+/**
+ * Writes the frame bytes as is (API mode 1).
+ * Calculates the checksum on the fly.
+ */
+class Writer {
+public:
+	// maximum number of output bytes per input byte
+	static const std::size_t EXPANSION = 1;
+
+	Writer(uint8_t* p): mCursor(p), mSum(0) {}
+
+	void put(uint8_t b) {
+		mSum += b;
+		*(mCursor++) = b;
+	}
+	void put(const uint8_t* data, std::size_t size) {
+		if (size) {
+			mSum += XBeeFrameChecksum::sum(data, size);
+			std::memcpy(mCursor, data, size);
+			mCursor += size;
+		}
+	}
+	void putDelimiter() { *(mCursor++) = XBeeFrameDelimiter::VALUE; }
+	void resetSum() { mSum = 0; }
+	uint8_t getSum() const { return mSum; }
+	uint8_t* getCursor() const { return mCursor; }
+private:
+	uint8_t*		mCursor;
+	uint8_t			mSum;
+};
+
+/**
+ * Writes the frame bytes with escapes (API mode 2).
+ * Calculates the checksum on the fly.
+ */
+class EscapedWriter {
+public:
+	// maximum number of output bytes per input byte
+	static const std::size_t EXPANSION = 2;
+
+	EscapedWriter(uint8_t* p): mCursor(p), mSum(0) {}
+
+	void put(uint8_t b) {
+		mSum += b;
+		if (XBeeFrameEscape::isNeeded(b)) {
+			*(mCursor++) = XBeeFrameEscape::ESCAPE;
+			*(mCursor++) = XBeeFrameEscape::apply(b);
+		} else {
+			*(mCursor++) = b;
+		}
+	}
+	void put(const uint8_t* data, std::size_t size) {
+		for (std::size_t i = 0; i < size; i++) {
+			put(data[i]);
+		}
+	}
+	void putDelimiter() { *(mCursor++) = XBeeFrameDelimiter::VALUE; }
+	void resetSum() { mSum = 0; }
+	uint8_t getSum() const { return mSum; }
+	uint8_t* getCursor() const { return mCursor; }
+private:
+	uint8_t*		mCursor;
+	uint8_t			mSum;
+};
+
+///////////////////// Layout helpers /////////////////////
+namespace Internal {
+
+template<typename... tFields> struct Size;
+template<> struct Size<> {
+	static const std::size_t value = 0;
+};
+template<typename tHead, typename... tTail> struct Size<tHead, tTail...> {
+	static const std::size_t value = tHead::SIZE + Size<tTail...>::value;
+};
+
+template<typename tField, typename... tFields> struct Offset;
+template<typename tField, typename... tTail> struct Offset<tField, tField, tTail...> {
+	static const std::size_t value = 0;
+};
+template<typename tField, typename tHead, typename... tTail> struct Offset<tField, tHead, tTail...> {
+	static const std::size_t value = tHead::SIZE + Offset<tField, tTail...>::value;
+};
+
+} /* namespace Internal */
+
+///////////////////// Frame /////////////////////
+/**
+ * Layout of the API frame
+ *
+ * @param tApiId the API Id
+ * @param tFields fixed size fields following the API Id
+ */
+template<XBeeFrameApiId::type tApiId, typename... tFields> struct Frame {
+	static const XBeeFrameApiId::type API_ID = tApiId;
+	/**
+	 * Size of the fixed part including API Id
+	 */
+	static const std::size_t FIXED_SIZE = 1 + Internal::Size<tFields...>::value;
+
+	/**
+	 * Field value
+	 *
+	 * @param payload pointer to the API Id byte
+	 */
+	template<typename tField>
+	static typename tField::type get(const uint8_t* payload) {
+		return tField::decode(payload + 1 + Internal::Offset<tField, tFields...>::value);
+	}
+
+	/**
+	 * Encodes the frame in one pass: length, escapes and checksum
+	 *
+	 * @param tWriter Writer (API mode 1) or EscapedWriter (API mode 2)
+	 * @param buffer output buffer
+	 * @param values values of the fixed fields
+	 * @param data variable size tail
+	 * @param size size of the tail
+	 */
+	template<typename tWriter>
+	static void encode(XBeeBuffer& buffer, typename tFields::type... values,
+			const uint8_t* data, std::size_t size)
+	{
+		const std::size_t length = FIXED_SIZE + size;
+		// the worst case is known in advance => no reallocations
+		buffer.resize(1 + tWriter::EXPANSION * (Length::SIZE + length + XBEE_FRAME_CHECKSUM_SIZE));
+		tWriter w(&buffer[0]);
+		w.putDelimiter();
+		Length::write(w, static_cast<Length::type>(length));
+		// checksum covers the bytes between the length and checksum fields
+		w.resetSum();
+		w.put(API_ID);
+		int dummy[] = {0, (tFields::write(w, values), 0)...};
+		(void) dummy;
+		w.put(data, size);
+		w.put(static_cast<uint8_t>(0xFF - w.getSum()));
+		buffer.resize(w.getCursor() - &buffer[0]);
+	}
+
+	/**
+	 * Encodes the frame for the selected API mode
+	 */
+	static void encode(XBeeFrameApiMode::Type mode, XBeeBuffer& buffer, typename tFields::type... values,
+			const uint8_t* data, std::size_t size)
+	{
+		if (mode == XBeeFrameApiMode::ESCAPED) {
+			encode<EscapedWriter>(buffer, values..., data, size);
+		} else {
+			encode<Writer>(buffer, values..., data, size);
+		}
+	}
+};
+
+///////////////////// Frames /////////////////////
+typedef Frame<XBeeFrameApiId::AT_CMD,
+		FrameId, AtCommand>												AtCmd;
+typedef Frame<XBeeFrameApiId::ZB_TX_REQ,
+		FrameId, Addr64, Addr16, Radius, Options>							ZbTxReq;
+typedef Frame<XBeeFrameApiId::AT_CMD_RSP,
+		FrameId, AtCommand, AtStatus>										AtCmdRsp;
+typedef Frame<XBeeFrameApiId::MODEM_STATUS,
+		ModemStatus>														ModemStatusRsp;
+typedef Frame<XBeeFrameApiId::ZB_TX_STATUS,
+		FrameId, Addr16, TxRetryCount, DeliveryStatus, DiscoveryStatus>	ZbTxStatus;
+typedef Frame<XBeeFrameApiId::ZB_RX_RSP,
+		Addr64, Addr16, Options>											ZbRxRsp;
+typedef Frame<XBeeFrameApiId::ZB_EXPLICIT_RX_RSP,
+		Addr64, Addr16, SrcEndpoint, DstEndpoint, ClusterId, ProfileId,
+		Options>															ZbExplicitRxRsp;
+typedef Frame<XBeeFrameApiId::ZB_IO_SAMPLE_RSP,
+		Addr64, Addr16, Options, SamplesQty, DigitalMask, AnalogMask>		ZbIoSampleRsp;
+typedef Frame<XBeeFrameApiId::ZB_NODE_ID_RSP,
+		Addr64, Addr16, Options>											ZbNodeIdRsp;
+typedef Frame<XBeeFrameApiId::ZB_ROUTE_RECORD,
+		Addr64, Addr16, Options, AddressesQty>								ZbRouteRecord;
+
+///////////////////// Table /////////////////////
+/**
+ * Jump table indexed by API Id.
+ * Gives the fixed part size of the known frames; unknown frames have zero size.
+ */
+template<typename... tFrames> class Table {
+public:
+	static const Table& get() {
+		static const Table table;
+		return table;
+	}
+
+	bool isKnown(uint8_t apiId) const { return mFixedSize[apiId]; }
+	std::size_t getFixedSize(uint8_t apiId) const { return mFixedSize[apiId]; }
+
+	/**
+	 * Jump table of the frame handlers indexed by API Id.
+	 * 'tHandler<Frame>::handle(args...)' is generated for every frame of the table,
+	 * unknown frames go to 'tHandler<void>::handle(args...)'.
+	 *
+	 * @param tHandler handler template, specialized for the frames with consumers
+	 * @param tArgs arguments of the handlers
+	 */
+	template<template<typename> class tHandler, typename... tArgs> class Dispatcher {
+	public:
+		static const Dispatcher& get() {
+			static const Dispatcher dispatcher;
+			return dispatcher;
+		}
+
+		void dispatch(uint8_t apiId, tArgs... args) const { mHandlers[apiId](args...); }
+	private:
+		typedef void (*Handler)(tArgs...);
+		Handler			mHandlers[256];
+
+		Dispatcher() {
+			for (Handler& i: mHandlers) {
+				i = &tHandler<void>::handle;
+			}
+			int dummy[] = {0, ((mHandlers[tFrames::API_ID] = &tHandler<tFrames>::handle), 0)...};
+			(void) dummy;
+		}
+	};
+private:
+	uint16_t		mFixedSize[256];
+
+	Table(): mFixedSize() {
+		int dummy[] = {0, ((mFixedSize[tFrames::API_ID] = tFrames::FIXED_SIZE), 0)...};
+		(void) dummy;
+	}
+};
+
+typedef Table<
+	AtCmd,
+	ZbTxReq,
+	AtCmdRsp,
+	ModemStatusRsp,
+	ZbTxStatus,
+	ZbRxRsp,
+	ZbExplicitRxRsp,
+	ZbIoSampleRsp,
+	ZbNodeIdRsp,
+	ZbRouteRecord
+>																			Frames;
+
+} /* namespace XBeeFrameSchema */
+
+#endif /* XBEE_FRAME_SCHEMA_H_ */
@@ -14,187 +14,270 @@
 /* Internal Includes */
 #include "XBeeNet.h"
 #include "XBeeFrame.h"
+#include "XBeeFrameSchema.h"
+#include "XBeeNetTx.h"
+#include "XBeeNetFromBuffer.h"
+#include "Mqtt.h"
 /* External Includes */
 #include "Error.h"
 #include "Application.h"
+#include "Configuration.h"
 #include "CommandProcessor.h"
 #include "Router.h"
+#include "SerialPort.h"
+#include "TcpNet.h"
 #include "NetworkingDataUnit.h"
-#include "Memory.h"
 /* System Includes */
 #include <assert.h>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+#include <mutex>
 
 
-#define API_START_DELIM						((uint8_t) 0x7E)
-#define API_ESCAPE							((uint8_t) 0x7D)
-#define API_XON								((uint8_t) 0x11)
-#define API_XOFF							((uint8_t) 0x13)
-#define DO_API_ESCPE(x)						((x)^0x20)
+#define XBEE_NET_MTU_DEFAULT				66		// NP of ZigBee with enabled network encryption
+#define XBEE_NET_MTU_APS_OVERHEAD			4
+#define XBEE_NET_MTU_QUERY_PERIOD_MS		5000
+#define XBEE_NET_AT_FRAME_ID				((XBeeFrameId::type) 1)
+#define XBEE_NET_BAUD_TIMEOUT_MS			1000
+#define XBEE_NET_BAUD_ATTEMPTS				3
 
-///////////////////// XBeeNetFromBuffer /////////////////////
-class XBeeNetFromBuffer {
+///////////////////// XBeeNetToBuffer /////////////////////
+/**
+ * Packs the downlink byte stream of one destination to frames.
+ * The stream is split by MQTT packets; whole packets are packed to as few
+ * frames as possible and only packets bigger than MTU are split. Not full
+ * frame could wait more packets till the flush deadline.
+ */
+class XBeeNetToBuffer {
 public:
-	typedef std::function<void(std::unique_ptr<XBeeBuffer>)> onFrame;
+	typedef std::function<void(std::unique_ptr<Networking::Buffer>)> onFrame;
 
-	XBeeNetFromBuffer(onFrame cbk):
-		mLog(__FUNCTION__),
+	XBeeNetToBuffer(onFrame cbk):
 		mOnFrameCbk(cbk),
-		mBuffer(new XBeeBuffer),
-		mIsEscapeSequence(false),
-		mFrameLength(0)
+		mParsed(0),
+		mTail(0),
+		mIsFlushScheduled(false)
 	{
 	}
 
 	/**
-	 * Copies bytes with Escapes removing
+	 * Appends the data and sends the full frames
+	 *
+	 * @param data downlink stream chunk
+	 * @param mtu maximum frame data size
+	 * @param isForced send everything wo waiting more packets
+	 * @return true if some data waits the flush
+	 */
+	bool push(const Networking::Buffer& data, std::size_t mtu, bool isForced) {
+		mBuffer.insert(mBuffer.end(), data.begin(), data.end());
+		return flush(mtu, isForced);
+	}
+
+	/**
+	 * Sends the frames
 	 *
-	 * @param buffer XBee network buffer
+	 * @param mtu maximum frame data size
+	 * @param isForced send everything wo waiting more packets
+	 * @return true if some data waits the flush
 	 */
-	void push(const XBeeBuffer& buffer) {
-		for (uint8_t b: buffer) {
-			push(b);
-			// get length; length is 16-bit [1:2] bytes
-			if (!mFrameLength && mBuffer->size()>=3) {
-				uint8_t b1 = (*mBuffer)[1];
-				uint8_t b2 = (*mBuffer)[2];
-				mFrameLength = ((((uint16_t)b1)<<8) & 0xFF00) | (b2 & 0x00FF);
-				*mLog.debug() << UTILS_STR_FUNCTION << ", frame-length: "<< getFrameSize();
-				if (getFrameSize() > 200) {
-					*mLog.warn() << UTILS_STR_FUNCTION << ", frame-length is huge";
-				}
-				mBuffer->reserve(static_cast<XBeeBuffer::size_type>(getFrameSize()));
+	bool flush(std::size_t mtu, bool isForced) {
+		const std::size_t size = mBuffer.size();
+		std::size_t frameStart = 0;
+		std::size_t offset = mParsed;
+		while (offset < size) {
+			std::size_t packetSize = mTail;
+			if (!packetSize && !Mqtt::getPacketSize(mBuffer.data() + offset, size - offset, packetSize)) {
+				break;
 			}
-			// check length
-			if (mFrameLength && mBuffer->size() >= getFrameSize()) {
-				if (mBuffer->size() != getFrameSize()) {
-					*mLog.warn() << UTILS_STR_FUNCTION << ", new-frame.size != frame-length"
-							<< "[" << mBuffer->size() << "!=" << getFrameSize() << "]";
-				}
-				// frame is received
-				pop();
+			if (packetSize > size - offset) {
+				break;
+			}
+			// the packet doesn't fit => send collected packets
+			if (offset > frameStart && offset + packetSize - frameStart > mtu) {
+				send(frameStart, offset);
+				frameStart = offset;
+			}
+			// the packet is bigger than MTU => split
+			while (offset + packetSize - frameStart > mtu) {
+				send(frameStart, frameStart + mtu);
+				frameStart += mtu;
+			}
+			offset += packetSize;
+			mTail = 0;
+		}
+		if (isForced) {
+			std::size_t end = offset;
+			std::size_t packetSize = mTail;
+			// incomplete fixed header is kept to stay in sync with packets
+			if (offset < size && (packetSize || Mqtt::getPacketSize(mBuffer.data() + offset, size - offset, packetSize))) {
+				end = size;
+				mTail = packetSize - (size - offset);
+			}
+			while (frameStart < end) {
+				const std::size_t frameEnd = frameStart + std::min(mtu, end - frameStart);
+				send(frameStart, frameEnd);
+				frameStart = frameEnd;
 			}
 		}
-		*mLog.debug() << UTILS_STR_FUNCTION << ", new-frame.current-size: "<< mBuffer->size();
+		mBuffer.erase(mBuffer.begin(), mBuffer.begin() + frameStart);
+		mParsed = offset > frameStart ? offset - frameStart : 0;
+		return !mBuffer.empty();
 	}
 
+	// Accessors
+	bool isFlushScheduled() const { return mIsFlushScheduled; }
+	void setFlushScheduled(bool v) { mIsFlushScheduled = v; }
 private:
 	// Objects
-	Utils::Logger								mLog;
 	onFrame										mOnFrameCbk;
-	std::unique_ptr<XBeeBuffer>					mBuffer;
-	bool										mIsEscapeSequence;
-	uint16_t									mFrameLength;
+	Networking::Buffer							mBuffer;
+	// size of whole packets at the buffer start
+	std::size_t									mParsed;
+	// remaining size of the partially sent packet
+	std::size_t									mTail;
+	bool										mIsFlushScheduled;
 
-	/**
-	 * Processes one byte
-	 */
-	void push(uint8_t b) {
-		// wait the start of the frame
-		if (mBuffer->empty()) {
-			switch (b) {
-				case API_START_DELIM:
-					*mLog.debug() << UTILS_STR_FUNCTION << ", new-frame started";
-					mBuffer->push_back(b);
-					// no break
-				default:
-					// skip
-					return;
-			}
-		}
-		// process Escape sequence
-		if (mIsEscapeSequence) {
-			switch (b) {
-				case DO_API_ESCPE(API_START_DELIM):
-				case DO_API_ESCPE(API_ESCAPE):
-				case DO_API_ESCPE(API_XON):
-				case DO_API_ESCPE(API_XOFF):
-					*mLog.trace() << UTILS_STR_FUNCTION << ", escaping "
-						<< Utils::putByte(b) << " => " << Utils::putByte(DO_API_ESCPE(b));
-					mIsEscapeSequence = false;
-					mBuffer->push_back(DO_API_ESCPE(b));
-					return;
-				default:
-					*mLog.warn() << UTILS_STR_FUNCTION << ", bad Escape";
-					drop();
-					return;
-			}
-		}
-		// other characters
-		switch (b) {
-			case API_ESCAPE:
-				mIsEscapeSequence = true;
-				return;
-			case API_START_DELIM:
-				*mLog.warn() << UTILS_STR_FUNCTION << ", unexpected start of next frame";
-				pop();
-				// no break
-			default:
-				mBuffer->push_back(b);
-				return;
-		}
+	void send(std::size_t begin, std::size_t end) {
+		mOnFrameCbk(std::unique_ptr<Networking::Buffer>(
+				new Networking::Buffer(mBuffer.begin() + begin, mBuffer.begin() + end)));
 	}
+};
 
+///////////////////// XBeeNetAddrCache /////////////////////
+/**
+ * 64-bit to 16-bit network address cache.
+ * Sending with known 16-bit address avoids the network address discovery.
+ * The 16-bit address could be changed when the device re-joins the network
+ * => the entry is invalidated on delivery failure.
+ */
+class XBeeNetAddrCache {
+public:
 	/**
-	 * Notifies about new received frame and starts assembling of a new one.
+	 * Gets the 16-bit address
+	 *
+	 * @return the cached address or XBeeFrameAddr16::UNKNOWN
 	 */
-	void pop() {
-		mOnFrameCbk(std::move(mBuffer));
-		drop();
+	XBeeFrameAddr16::type get(XBeeFrameAddr64::type addr64) const {
+		std::unordered_map<XBeeFrameAddr64::type, XBeeFrameAddr16::type>::const_iterator i = mCache.find(addr64);
+		if (i == mCache.end()) {
+			return XBeeFrameAddr16::UNKNOWN;
+		}
+		return i->second;
 	}
 
 	/**
-	 * Drops current context.
+	 * Updates the entry
 	 */
-	void drop() {
-		mBuffer.reset(new XBeeBuffer);
-		mIsEscapeSequence = false;
-		mFrameLength = 0;
-	}
-
-	uint32_t getFrameSize() {
-		uint32_t res = 0;
-		if (mFrameLength) {
-			res =	1					// API_START_DELIM
-					+ 2					// 16-bit length
-					+ mFrameLength		// Payload
-					+ 1;				// Checksum
+	void set(XBeeFrameAddr64::type addr64, XBeeFrameAddr16::type addr16) {
+		if (addr16 == XBeeFrameAddr16::UNKNOWN) {
+			mCache.erase(addr64);
+		} else {
+			mCache[addr64] = addr16;
 		}
-		return res;
 	}
+
+private:
+	std::unordered_map<XBeeFrameAddr64::type, XBeeFrameAddr16::type>	mCache;
 };
 
-///////////////////// XBeeNetTo /////////////////////
-class XBeeNetTo {
-public:
-	static void addEscapes(XBeeBuffer& buffer) {
-		for (auto it = buffer.begin(); it!=buffer.end(); it++) {
-			switch (*it) {
-				default:
-					continue;
-				case API_START_DELIM:
-					if (it==buffer.begin()) {
-						// do not escape the first byte
-						continue;
-					}
-				// no break
-				case API_ESCAPE:
-				case API_XON:
-				case API_XOFF:
-					break;
-			}
-			// do escape
-			it = buffer.insert(it, API_ESCAPE);
-			++it;
-			*it = DO_API_ESCPE(*it);
-		}
-	}
+///////////////////// XBeeNetRadio /////////////////////
+/**
+ * Coordinator connected to one serial port.
+ * Frame Ids, 16-bit addresses and MTU are valid only inside own network
+ * => every coordinator has own assembler, encoder state and flow control.
+ */
+struct XBeeNetRadio {
+	typedef std::function<void(XBeeNetRadio&, std::unique_ptr<XBeeBuffer>)> FrameCbk;
+	typedef std::function<void(XBeeNetRadio&, XBeeFrameId::type, XBeeFrameAddr64::type,
+			const Networking::Buffer&)> SendCbk;
+
+	const Networking::AddressSerial*				port;
+	// resolved once => no lookup by the name on the data path
+	SerialPort*										serial;
+	const XBeeFrameApiMode::Type					apiMode;
+	XBeeNetFromBuffer								fromBuffer;
+	XBeeNetAddrCache								addrCache;
+	XBeeNetTx										tx;
+	// maximum data size in one frame
+	std::size_t										mtu;
+	bool											isMtuKnown;
+	std::chrono::steady_clock::time_point			mtuQueryTime;
+	// reception time of the buffer being assembled
+	Networking::Time								rxTime;
+	// baud rate negotiation
+	struct Baud {
+		typedef enum {
+			IDLE,
+			SET,			// BD is sent at the initial rate
+			VERIFY,			// BD is queried at the target rate
+			CHECK,			// BD is queried at the initial rate, the target rate doesn't respond
+		} State;
+		State										state;
+		uint32_t									initial;
+		uint32_t									target;
+		// queries at the target rate
+		uint32_t									attempts;
+		// ignores the time-outs of the previous steps
+		uint32_t									step;
+	} baud;
+	XBeeNetRadio(const Networking::AddressSerialValT& name, XBeeFrameApiMode::Type mode,
+			FrameCbk frame, SendCbk send, XBeeNetTx::BlockCbk block, XBeeNetTx::ResetCbk reset)
+	:
+		port(Networking::AddressSerial::intern(name)),
+		serial(nullptr),
+		apiMode(mode),
+		fromBuffer(name, mode, [this, frame] (std::unique_ptr<XBeeBuffer> a) {
+			frame(*this, std::move(a));
+		}),
+		tx(
+			[this, send] (XBeeFrameId::type frameId, XBeeFrameAddr64::type addr64, const Networking::Buffer& data) {
+				send(*this, frameId, addr64, data);
+			},
+			[this] (XBeeFrameAddr64::type addr64, XBeeFrameAddr16::type addr16, XBeeFrameDeliveryStatus::type status) {
+				// the 16-bit address could be changed => discover it again
+				addrCache.set(addr64,
+						status == XBeeFrameDeliveryStatus::SUCCESS ? addr16 : static_cast<XBeeFrameAddr16::type>(XBeeFrameAddr16::UNKNOWN));
+			},
+			block,
+			reset
+		),
+		mtu(XBEE_NET_MTU_DEFAULT),
+		isMtuKnown(false),
+		baud({Baud::IDLE, 0, 0, 0, 0})
+	{}
 };
 
 ///////////////////// XBeeNetContext /////////////////////
 struct XBeeNetContext {
 	Utils::CommandProcessor							processor;
-	std::unique_ptr<XBeeNetFromBuffer>				fromBuffer;
-	XBeeNetContext(const std::string& name) : processor(name) {}
+	// inline mode => the data is processed on the caller thread
+	bool											isInline;
+	// serializes the processing of the callers and processor threads
+	std::recursive_mutex							mtx;
+	// coordinator per serial port
+	std::map<Networking::AddressSerialValT, std::unique_ptr<XBeeNetRadio> >	radios;
+	// coordinator that received the last frame of the device
+	std::unordered_map<XBeeFrameAddr64::type, XBeeNetRadio*>	routes;
+	// interned address of the device => no global lock on the data path
+	std::unordered_map<XBeeFrameAddr64::type, const Networking::AddressXBeeNet*>	addresses;
+	// frame packer per destination
+	std::unordered_map<XBeeFrameAddr64::type, std::unique_ptr<XBeeNetToBuffer> >	toBuffers;
+	uint32_t										txCoalesceMs;
+	uint32_t										baudMax;
+	XBeeNetTx::Config								txConfig;
+	XBeeFrameOptionsSend::type						txOptions;
+	XBeeNetContext(const std::string& name)
+	:
+		processor(name),
+		isInline(false),
+		txCoalesceMs(0),
+		baudMax(0),
+		txConfig({2, 0, 32, 30000}),
+		txOptions(0)
+	{}
 };
 
 ///////////////////// XBeeNetCommands /////////////////////
@@ -205,55 +288,140 @@ public:
 
 class XBeeNetCommandFrom: public XBeeNetCommand {
 public:
-	typedef std::function<void(std::unique_ptr<XBeeBuffer>)> Cbk;
-	XBeeNetCommandFrom(Cbk cbk, std::unique_ptr<XBeeBuffer> data)
+	typedef std::function<void(const Networking::Address&,
+				std::unique_ptr<XBeeBuffer>, Networking::Time)> Cbk;
+	XBeeNetCommandFrom(Cbk cbk, const Networking::Address* from, std::unique_ptr<XBeeBuffer> data,
+			Networking::Time time)
 	:
 		mCbk(cbk),
-		mData(std::move(data))
+		mFrom(from),
+		mData(std::move(data)),
+		mTime(time)
 	{}
 
 	void execute() {
-		mCbk(std::move(mData));
+		mCbk(*mFrom, std::move(mData), mTime);
 	}
 private:
-	Cbk								mCbk;
-	std::unique_ptr<XBeeBuffer>		mData;
+	Cbk											mCbk;
+	const Networking::Address*					mFrom;
+	std::unique_ptr<XBeeBuffer>					mData;
+	Networking::Time							mTime;
 };
 
 class XBeeNetCommandTo: public XBeeNetCommand {
 public:
-	typedef std::function<void(std::unique_ptr<Networking::Address>,
-				std::unique_ptr<Networking::Address>,
+	typedef std::function<void(const Networking::Address&,
+				const Networking::Address&,
 				std::unique_ptr<Networking::Buffer>)> Cbk;
 	XBeeNetCommandTo(Cbk cbk,
 			const Networking::Address* from, const Networking::Address* to,
 			std::unique_ptr<Networking::Buffer> buffer)
 	:
 		mCbk(cbk),
-		mFrom(from->clone()),
-		mTo(to->clone()),
+		mFrom(from),
+		mTo(to),
 		mData(std::move(buffer))
 	{}
 
 	void execute() {
-		mCbk(std::move(mFrom), std::move(mTo), std::move(mData));
+		mCbk(*mFrom, *mTo, std::move(mData));
 	}
 private:
 	Cbk											mCbk;
-	std::unique_ptr<Networking::Address>		mFrom;
-	std::unique_ptr<Networking::Address>		mTo;
+	const Networking::Address*					mFrom;
+	const Networking::Address*					mTo;
 	std::unique_ptr<Networking::Buffer>			mData;
 };
 
+class XBeeNetCommandFlush: public XBeeNetCommand {
+public:
+	typedef std::function<void(XBeeFrameAddr64::type)> Cbk;
+	XBeeNetCommandFlush(Cbk cbk, XBeeFrameAddr64::type to)
+	:
+		mCbk(cbk),
+		mTo(to)
+	{}
+
+	void execute() {
+		mCbk(mTo);
+	}
+private:
+	Cbk											mCbk;
+	XBeeFrameAddr64::type						mTo;
+};
+
+class XBeeNetCommandPort: public XBeeNetCommand {
+public:
+	typedef std::function<void(const Networking::AddressSerialValT&, uint32_t)> Cbk;
+	XBeeNetCommandPort(Cbk cbk, const Networking::AddressSerialValT& port, uint32_t value)
+	:
+		mCbk(cbk),
+		mPort(port),
+		mValue(value)
+	{}
+
+	void execute() {
+		mCbk(mPort, mValue);
+	}
+private:
+	Cbk											mCbk;
+	Networking::AddressSerialValT				mPort;
+	uint32_t									mValue;
+};
+
+///////////////////// XBeeNetFrameHandler /////////////////////
+/**
+ * Consumer of the received frame, selected by the API Id through the jump table
+ * generated from the frames table. The frames without consumers are skipped.
+ */
+template<typename tFrame> struct XBeeNetFrameHandler {
+	static void handle(XBeeNet&, XBeeNetRadio&, std::unique_ptr<XBeeBuffer>&, const XBeeFrameView&) {}
+};
+
+template<> struct XBeeNetFrameHandler<XBeeFrameSchema::ZbRxRsp> {
+	static void handle(XBeeNet& net, XBeeNetRadio& radio, std::unique_ptr<XBeeBuffer>& buffer,
+			const XBeeFrameView& frame)
+	{
+		net.onRxRsp(radio, std::move(buffer), frame);
+	}
+};
+
+template<> struct XBeeNetFrameHandler<XBeeFrameSchema::ZbTxStatus> {
+	static void handle(XBeeNet& net, XBeeNetRadio& radio, std::unique_ptr<XBeeBuffer>&,
+			const XBeeFrameView& frame)
+	{
+		net.onTxStatus(radio, frame);
+	}
+};
+
+template<> struct XBeeNetFrameHandler<XBeeFrameSchema::ModemStatusRsp> {
+	static void handle(XBeeNet& net, XBeeNetRadio& radio, std::unique_ptr<XBeeBuffer>&,
+			const XBeeFrameView& frame)
+	{
+		net.onModemStatus(radio, frame);
+	}
+};
+
+template<> struct XBeeNetFrameHandler<XBeeFrameSchema::AtCmdRsp> {
+	static void handle(XBeeNet& net, XBeeNetRadio& radio, std::unique_ptr<XBeeBuffer>&,
+			const XBeeFrameView& frame)
+	{
+		net.onAtCmdRsp(radio, frame);
+	}
+};
+
+typedef XBeeFrameSchema::Frames::Dispatcher<XBeeNetFrameHandler,
+		XBeeNet&, XBeeNetRadio&, std::unique_ptr<XBeeBuffer>&, const XBeeFrameView&>	XBeeNetFrameDispatcher;
+
 ///////////////////// XBeeNet /////////////////////
 XBeeNet::XBeeNet()
 :
 	mLog(__FUNCTION__),
 	mCtx(new XBeeNetContext(mLog.getName()))
 {
-	mCtx->fromBuffer.reset(new XBeeNetFromBuffer( [this] (std::unique_ptr<XBeeBuffer> a) {
-		onFrame(std::move(a));
-	}));
+	// the ports could deliver data before start()
+	mCtx->isInline = (Utils::Configuration::get().router.mode == "inline");
 }
 
 XBeeNet::~XBeeNet() {
@@ -261,6 +429,20 @@ XBeeNet::~XBeeNet() {
 }
 
 void XBeeNet::start() {
+	std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
+	const Utils::Configuration& config = Utils::Configuration::get();
+	mCtx->txConfig = {
+		config.xbee.txWindow,
+		config.xbee.txRetries,
+		config.xbee.txQueueSize,
+		config.xbee.txTimeoutMs
+	};
+	mCtx->txOptions = config.xbee.txEncryption ? XBeeFrameOptionsSend::ENABLE_ENCRYPTION_APS : 0;
+	mCtx->txCoalesceMs = config.xbee.txCoalesceMs;
+	mCtx->baudMax = config.serial.baudMax;
+	for (const Utils::Configuration::Serial::Port& i: config.serial.ports) {
+		getRadio(i.name);
+	}
 	mCtx->processor.start();
 }
 
@@ -268,14 +450,25 @@ void XBeeNet::stop() {
 	mCtx->processor.stop();
 }
 
-void XBeeNet::from(std::unique_ptr<XBeeBuffer> buffer)
+void XBeeNet::from(const Networking::Address* from, std::unique_ptr<XBeeBuffer> buffer,
+		Networking::Time time)
 throw ()
 {
+	assert(from);
+	assert(from->getOrigin()==Networking::Origin::SERIAL);
+	assert(buffer.get());
+
+	if (mCtx->isInline) {
+		onFrom(*from, std::move(buffer), time);
+		return;
+	}
 	std::unique_ptr<Utils::Command> cmd (new XBeeNetCommandFrom(
-		[this] (std::unique_ptr<XBeeBuffer> a) {
-				onFrom(std::move(a));
+		[this] (const Networking::Address& a, std::unique_ptr<XBeeBuffer> b, Networking::Time c) {
+				onFrom(a, std::move(b), c);
 		},
-		std::move(buffer)
+		from,
+		std::move(buffer),
+		time
 	));
 	mCtx->processor.process(std::move(cmd));
 }
@@ -289,91 +482,465 @@ throw ()
 	assert(to->getOrigin()==Networking::Origin::XBEE);
 	assert(buffer.get());
 
+	if (mCtx->isInline) {
+		onTo(*from, *to, std::move(buffer));
+		return;
+	}
+	// MQTT control packets overtake the bulk data of other devices
+	const Utils::CommandProcessor::Lane::Type lane = Mqtt::isControl(buffer->data(), buffer->size()) ?
+			Utils::CommandProcessor::Lane::HIGH : Utils::CommandProcessor::Lane::NORMAL;
+	const uint64_t stream = static_cast<const Networking::AddressXBeeNet*>(to)->get().value;
 	std::unique_ptr<Utils::Command> cmd (new XBeeNetCommandTo(
-			[this] (std::unique_ptr<Networking::Address> a, std::unique_ptr<Networking::Address> b,
+			[this] (const Networking::Address& a, const Networking::Address& b,
 					std::unique_ptr<Networking::Buffer> c) {
-					onTo(std::move(a), std::move(b), std::move(c));
+					onTo(a, b, std::move(c));
 			},
 			from,
 			to,
 			std::move(buffer)
 	));
+	mCtx->processor.process(std::move(cmd), lane, stream);
+}
+
+void XBeeNet::opened(const Networking::Address* port, uint32_t baud)
+throw ()
+{
+	assert(port);
+	assert(port->getOrigin()==Networking::Origin::SERIAL);
+
+	std::unique_ptr<Utils::Command> cmd (new XBeeNetCommandPort(
+			[this] (const Networking::AddressSerialValT& a, uint32_t b) {
+				onOpened(a, b);
+			},
+			static_cast<const Networking::AddressSerial*>(port)->get(),
+			baud
+	));
 	mCtx->processor.process(std::move(cmd));
 }
 
 ///////////////////// XBeeNet::Internal /////////////////////
-void XBeeNet::onFrom(std::unique_ptr< std::vector<uint8_t> > buffer) {
-	*mLog.debug() << UTILS_STR_FUNCTION << ", buffer.size: " << buffer->size();
-	*mLog.trace() << UTILS_STR_FUNCTION << ", buffer: " << Utils::putArray(*buffer);
-	mCtx->fromBuffer->push(*buffer);
+void XBeeNet::onFrom(const Networking::Address& from, std::unique_ptr< std::vector<uint8_t> > buffer,
+		Networking::Time time) {
+	std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
+	if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+		*mLog.debug() << UTILS_STR_FUNCTION << ", buffer.size: " << buffer->size();
+	}
+	if (mLog.isEnabled(Utils::LoggerLevel::TRACE)) {
+		*mLog.trace() << UTILS_STR_FUNCTION << ", buffer: " << Utils::putArray(*buffer);
+	}
+	const Networking::AddressSerialValT& source = static_cast<const Networking::AddressSerial&>(from).get();
+	XBeeNetRadio& radio = getRadio(source);
+	// frames are completed by this buffer => latency is counted from its reception
+	radio.rxTime = time;
+	radio.fromBuffer.push(*buffer);
+	if (radio.serial) {
+		radio.serial->recycle(std::move(buffer));
+	}
 }
 
-void XBeeNet::onTo(std::unique_ptr<Networking::Address> from_, std::unique_ptr<Networking::Address> to_,
+void XBeeNet::onTo(const Networking::Address& from_, const Networking::Address& to_,
 		std::unique_ptr<Networking::Buffer> buffer_) {
-	try {
-		// get address
-		std::unique_ptr<Networking::AddressXBeeNet> tTo =
-				Utils::dynamic_unique_ptr_cast<Networking::AddressXBeeNet, Networking::Address>(to_);
-		assert(tTo.get());
-		// make frame
-		XBeeFrame newframe(std::unique_ptr<XBeeFrameApiId>(new XBeeFrameApiId(XBeeFrameApiId::ZB_TX_REQ)));
-		newframe.setId(std::unique_ptr<XBeeFrameId>(new XBeeFrameId(XBeeFrameId::NO_RSP)));
-		newframe.setRadius(std::unique_ptr<XBeeFrameRadius>(new XBeeFrameRadius(XBeeFrameRadius::MAX)));
-		newframe.setAddr64Dst(std::unique_ptr<XBeeFrameAddr64Dst>(new XBeeFrameAddr64Dst(tTo->get())));
-		newframe.setAddr16Dst(std::unique_ptr<XBeeFrameAddr16Dst>(new XBeeFrameAddr16Dst(XBeeFrameAddr16Dst::UNKNOWN)));
-		newframe.setOptionsSend(std::unique_ptr<XBeeFrameOptionsSend>(new XBeeFrameOptionsSend()));
-		newframe.setData(std::unique_ptr<XBeeFrameData>(new XBeeFrameData(
-				buffer_->begin(),
-				buffer_->end())));
-		std::unique_ptr<XBeeBuffer> buffer(new XBeeBuffer);
-		newframe.encode(*buffer);
+	std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
+	// get address
+	assert(to_.getOrigin()==Networking::Origin::XBEE);
+	const Networking::AddressXBeeNet& tTo = static_cast<const Networking::AddressXBeeNet&>(to_);
+	if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
 		*mLog.debug() << UTILS_STR_FUNCTION << ", data.size: "
-			<< newframe.getData()->getValue().size();
+			<< buffer_->size();
+	}
+	if (mLog.isEnabled(Utils::LoggerLevel::TRACE)) {
 		*mLog.trace() << UTILS_STR_FUNCTION << ", data: "
-			<< Utils::putArray(newframe.getData()->getValue());
+			<< Utils::putArray(*buffer_);
+	}
+	const XBeeFrameAddr64::type addr64 = tTo.get();
+	XBeeNetRadio* radio = getRoute(addr64);
+	if (!radio) {
+		*mLog.warn() << UTILS_STR_FUNCTION << ", no coordinator => drop, addr: " << tTo.get();
+		return;
+	}
+	queryMtu(*radio);
+	std::unique_ptr<XBeeNetToBuffer>& toBuffer = mCtx->toBuffers[addr64];
+	if (!toBuffer) {
+		toBuffer.reset(new XBeeNetToBuffer([this, addr64] (std::unique_ptr<Networking::Buffer> a) {
+			XBeeNetRadio* radio = getRoute(addr64);
+			if (radio) {
+				radio->tx.send(addr64, std::move(a), getMtu(*radio));
+			}
+		}));
+	}
+	const bool isWaiting = toBuffer->push(*buffer_, getMtu(*radio), !mCtx->txCoalesceMs);
+	if (isWaiting && !toBuffer->isFlushScheduled()) {
+		toBuffer->setFlushScheduled(true);
+		std::unique_ptr<Utils::Command> cmd (new XBeeNetCommandFlush(
+				[this] (XBeeFrameAddr64::type a) {
+					onFlush(a);
+				},
+				addr64
+		));
+		mCtx->processor.process(std::move(cmd), mCtx->txCoalesceMs);
+	}
+}
+
+void XBeeNet::onFlush(XBeeFrameAddr64::type to) {
+	std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
+	std::unique_ptr<XBeeNetToBuffer>& toBuffer = mCtx->toBuffers[to];
+	XBeeNetRadio* radio = getRoute(to);
+	if (toBuffer && radio) {
+		toBuffer->setFlushScheduled(false);
+		toBuffer->flush(getMtu(*radio), true);
+	}
+}
+
+void XBeeNet::onOpened(const Networking::AddressSerialValT& port, uint32_t baud) {
+	std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
+	XBeeNetRadio& radio = getRadio(port);
+	radio.baud.state = XBeeNetRadio::Baud::IDLE;
+	radio.baud.initial = baud;
+	radio.baud.target = baud;
+	radio.baud.attempts = 0;
+	radio.baud.step++;
+	// the module could be replaced while the port was closed; NP is answered before BD is applied
+	resetMtu(radio);
+	queryMtu(radio);
+	if (mCtx->baudMax <= baud) {
+		return;
+	}
+	*mLog.info() << "Negotiate baud: " << mCtx->baudMax << ", port: " << port;
+	radio.baud.target = mCtx->baudMax;
+	radio.baud.state = XBeeNetRadio::Baud::SET;
+	sendBaud(radio, true);
+}
+
+void XBeeNet::onBaud(XBeeNetRadio& radio, XBeeFrameAtStatus::type status, const uint8_t* data, std::size_t size) {
+	XBeeFrameBaudRate::type code = 0;
+	XBeeFrameBaudRate::toCode(radio.baud.target, code);
+	switch (radio.baud.state) {
+		case XBeeNetRadio::Baud::SET:
+			if (status != XBeeFrameAtStatus::OK) {
+				*mLog.warn() << "Baud is not supported by the module, status: " << Utils::putByte(status)
+					<< ", port: " << radio.port->get();
+				radio.baud.state = XBeeNetRadio::Baud::IDLE;
+				break;
+			}
+			// the module applies BD after the response
+			verifyBaud(radio);
+			break;
+		case XBeeNetRadio::Baud::VERIFY:
+		{
+			uint32_t value = 0;
+			for (std::size_t i = 0; i < size; i++) {
+				value = (value << 8) | data[i];
+			}
+			if (status != XBeeFrameAtStatus::OK || !size || value != code) {
+				*mLog.warn() << "Baud is not verified, status: " << Utils::putByte(status)
+					<< ", BD: " << value << " => fall back to " << radio.baud.initial;
+				setBaud(radio, radio.baud.initial);
+			} else {
+				*mLog.info() << "Baud: " << radio.baud.target << ", port: " << radio.port->get();
+			}
+			radio.baud.state = XBeeNetRadio::Baud::IDLE;
+		}
+			break;
+		case XBeeNetRadio::Baud::CHECK:
+			// the module responds at the initial rate => BD is not applied
+			*mLog.warn() << "Baud is not changed, status: " << Utils::putByte(status)
+				<< " => keep " << radio.baud.initial << ", port: " << radio.port->get();
+			radio.baud.state = XBeeNetRadio::Baud::IDLE;
+			break;
+		default:
+			break;
+	}
+}
+
+void XBeeNet::onBaudTimeout(const Networking::AddressSerialValT& port, uint32_t step) {
+	std::lock_guard<std::recursive_mutex> locker(mCtx->mtx);
+	XBeeNetRadio& radio = getRadio(port);
+	if (radio.baud.step != step) {
+		return;
+	}
+	switch (radio.baud.state) {
+		case XBeeNetRadio::Baud::SET:
+			// the module could keep the target rate since the previous negotiation => check it
+			*mLog.debug() << UTILS_STR_FUNCTION << ", no BD response at " << radio.baud.initial
+				<< ", port: " << port;
+			verifyBaud(radio);
+			break;
+		case XBeeNetRadio::Baud::VERIFY:
+			// the response could be lost => the module could be at any of the rates
+			*mLog.debug() << UTILS_STR_FUNCTION << ", no BD response at " << radio.baud.target
+				<< ", port: " << port;
+			setBaud(radio, radio.baud.initial);
+			radio.baud.state = XBeeNetRadio::Baud::CHECK;
+			sendBaud(radio, false);
+			break;
+		case XBeeNetRadio::Baud::CHECK:
+			if (radio.baud.attempts < XBEE_NET_BAUD_ATTEMPTS) {
+				verifyBaud(radio);
+				break;
+			}
+			*mLog.warn() << "No BD response at " << radio.baud.target << " and " << radio.baud.initial
+				<< " => keep " << radio.baud.initial << ", port: " << port;
+			radio.baud.state = XBeeNetRadio::Baud::IDLE;
+			break;
+		default:
+			break;
+	}
+}
+
+void XBeeNet::sendBaud(XBeeNetRadio& radio, bool isSet) {
+	XBeeFrameBaudRate::type code = 0;
+	XBeeFrameBaudRate::toCode(radio.baud.target, code);
+	std::unique_ptr<XBeeBuffer> buffer(new XBeeBuffer);
+	XBeeFrameSchema::AtCmd::encode(radio.apiMode, *buffer,
+			XBEE_NET_AT_FRAME_ID,				// Frame Id
+			XBeeFrameAtCommand::BD,				// AT Command
+			isSet ? &code : nullptr, isSet ? sizeof(code) : 0);
+	write(radio, std::move(buffer), XBeeFrameAddr64Dst::COORDINATOR);
+	std::unique_ptr<Utils::Command> cmd (new XBeeNetCommandPort(
+			[this] (const Networking::AddressSerialValT& a, uint32_t b) {
+				onBaudTimeout(a, b);
+			},
+			radio.port->get(),
+			++radio.baud.step
+	));
+	mCtx->processor.process(std::move(cmd), XBEE_NET_BAUD_TIMEOUT_MS);
+}
+
+void XBeeNet::verifyBaud(XBeeNetRadio& radio) {
+	setBaud(radio, radio.baud.target);
+	radio.baud.state = XBeeNetRadio::Baud::VERIFY;
+	radio.baud.attempts++;
+	sendBaud(radio, false);
+}
+
+void XBeeNet::setBaud(XBeeNetRadio& radio, uint32_t baud) {
+	if (radio.serial) {
+		radio.serial->setBaud(baud);
+	}
+}
+
+XBeeNetRadio& XBeeNet::getRadio(const Networking::AddressSerialValT& port) {
+	std::unique_ptr<XBeeNetRadio>& radio = mCtx->radios[port];
+	if (!radio) {
+		const Utils::Configuration& config = Utils::Configuration::get();
+		uint32_t apiMode = config.serial.apiMode;
+		for (const Utils::Configuration::Serial::Port& i: config.serial.ports) {
+			if (i.name == static_cast<const std::string&>(port)) {
+				apiMode = i.apiMode;
+			}
+		}
+		*mLog.debug() << UTILS_STR_FUNCTION << ", new, port: " << port << ", api-mode: " << apiMode;
+		radio.reset(new XBeeNetRadio(port, static_cast<XBeeFrameApiMode::Type>(apiMode),
+			[this] (XBeeNetRadio& r, std::unique_ptr<XBeeBuffer> a) {
+				onFrame(r, std::move(a));
+			},
+			[this] (XBeeNetRadio& r, XBeeFrameId::type frameId, XBeeFrameAddr64::type addr64, const Networking::Buffer& data) {
+				onSend(r, frameId, addr64, data);
+			},
+			[this] (XBeeFrameAddr64::type addr64, bool isBlocked) {
+				// stop reading from the device connection till the queue drains
+				Application::get().getTcpNet().pauseRead(getAddress(addr64), isBlocked);
+			},
+			[this] (XBeeFrameAddr64::type addr64) {
+				// the device and the broker restart the session
+				Application::get().getTcpNet().reset(getAddress(addr64));
+			}
+		));
+		radio->tx.configure(mCtx->txConfig);
+		radio->serial = Application::get().getSerial(port);
+		resetMtu(*radio);
+	}
+	return *radio;
+}
+
+XBeeNetRadio* XBeeNet::getRoute(XBeeFrameAddr64::type addr64) {
+	std::unordered_map<XBeeFrameAddr64::type, XBeeNetRadio*>::const_iterator i = mCtx->routes.find(addr64);
+	if (i != mCtx->routes.end()) {
+		return i->second;
+	}
+	// the device was not heard yet => the first coordinator
+	return mCtx->radios.empty() ? nullptr : mCtx->radios.begin()->second.get();
+}
+
+const Networking::AddressXBeeNet* XBeeNet::getAddress(XBeeFrameAddr64::type addr64) {
+	const Networking::AddressXBeeNet*& res = mCtx->addresses[addr64];
+	if (!res) {
+		res = Networking::AddressXBeeNet::intern(addr64);
+	}
+	return res;
+}
+
+std::size_t XBeeNet::getMtu(const XBeeNetRadio& radio) const {
+	std::size_t mtu = radio.mtu;
+	if ((mCtx->txOptions & XBeeFrameOptionsSend::ENABLE_ENCRYPTION_APS) && mtu > XBEE_NET_MTU_APS_OVERHEAD) {
+		mtu -= XBEE_NET_MTU_APS_OVERHEAD;
+	}
+	return mtu;
+}
+
+void XBeeNet::onSend(XBeeNetRadio& radio, XBeeFrameId::type frameId, XBeeFrameAddr64::type addr64,
+		const Networking::Buffer& data) {
+	// make frame
+	const XBeeFrameAddr16::type addr16 = radio.addrCache.get(addr64);
+	std::unique_ptr<XBeeBuffer> buffer(new XBeeBuffer);
+	XBeeFrameSchema::ZbTxReq::encode(radio.apiMode, *buffer,
+			frameId,							// Frame Id
+			addr64,								// Destination Address 64
+			addr16,								// Destination Address 16
+			XBeeFrameRadius::MAX,				// Radius
+			mCtx->txOptions,					// Options
+			data.data(), data.size());
+	if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+		*mLog.debug() << UTILS_STR_FUNCTION << ", frame-id: " << Utils::putByte(frameId)
+			<< ", addr16: " << Utils::putByte(addr16 >> 8) << Utils::putByte(addr16)
+			<< ", frame.size: " << buffer->size();
+	}
+	write(radio, std::move(buffer), addr64);
+}
+
+void XBeeNet::resetMtu(XBeeNetRadio& radio) {
+	radio.mtuQueryTime = std::chrono::steady_clock::time_point();
+	if (Utils::Configuration::get().xbee.mtu) {
+		radio.mtu = Utils::Configuration::get().xbee.mtu;
+		radio.isMtuKnown = true;
+		return;
+	}
+	radio.mtu = XBEE_NET_MTU_DEFAULT;
+	radio.isMtuKnown = false;
+}
+
+void XBeeNet::queryMtu(XBeeNetRadio& radio) {
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (radio.isMtuKnown
+		|| (radio.mtuQueryTime != std::chrono::steady_clock::time_point()
+			&& now - radio.mtuQueryTime < std::chrono::milliseconds(XBEE_NET_MTU_QUERY_PERIOD_MS)))
+	{
+		return;
+	}
+	*mLog.debug() << UTILS_STR_FUNCTION << ", port: " << radio.port->get();
+	radio.mtuQueryTime = now;
+	std::unique_ptr<XBeeBuffer> buffer(new XBeeBuffer);
+	XBeeFrameSchema::AtCmd::encode(radio.apiMode, *buffer,
+			XBEE_NET_AT_FRAME_ID,				// Frame Id
+			XBeeFrameAtCommand::NP,				// AT Command
+			nullptr, 0);
+	write(radio, std::move(buffer), XBeeFrameAddr64Dst::COORDINATOR);
+}
+
+void XBeeNet::write(const XBeeNetRadio& radio, std::unique_ptr<XBeeBuffer> frame, XBeeFrameAddr64::type to) {
+	if (mLog.isEnabled(Utils::LoggerLevel::TRACE)) {
+		*mLog.trace() << UTILS_STR_FUNCTION << ", frame: "
+			<< Utils::putArray(*frame);
+	}
+	std::unique_ptr<Networking::DataUnit> unit(new Networking::DataUnitXBeeEncoder(
+			std::move(frame),
+			getAddress(to),
+			radio.port
+	));
+	Application::get().getRouter().process(std::move(unit));
+}
+
+void XBeeNet::onFrame(XBeeNetRadio& radio, std::unique_ptr<XBeeBuffer> buffer) {
+	if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
 		*mLog.debug() << UTILS_STR_FUNCTION << ", frame.size: "
 			<< buffer->size();
+	}
+	if (mLog.isEnabled(Utils::LoggerLevel::TRACE)) {
 		*mLog.trace() << UTILS_STR_FUNCTION << ", frame: "
 			<< Utils::putArray(*buffer);
-		XBeeNetTo::addEscapes(*buffer);
-		*mLog.debug() << UTILS_STR_FUNCTION << ", escaped-frame.size: "
-			<< buffer->size();
-		*mLog.trace() << UTILS_STR_FUNCTION << ", escaped-frame: "
-			<< Utils::putArray(*buffer);
-		std::unique_ptr<Networking::DataUnit> unit(new Networking::DataUnitXBeeEncoder(
-				std::move(buffer),
-				std::unique_ptr<Networking::Address>
-					(new Networking::AddressXBeeNet(tTo->get())),
-				std::unique_ptr<Networking::Address>()
-		));
-		Application::get().getRouter().process(std::move(unit));
-	} catch (Utils::Error& e) {
-		*mLog.error() << UTILS_STR_FUNCTION << ", error: " << e.what();
 	}
+	XBeeFrameView frame;
+	XBeeFrameStatus::Type status = frame.decode(*buffer);
+	switch (status) {
+		case XBeeFrameStatus::OK:
+			break;
+		case XBeeFrameStatus::NOT_IMPLEMENTED:
+			*mLog.debug() << UTILS_STR_FUNCTION << ", skip, api-id: " << Utils::putByte((*buffer)[XBEE_FRAME_HEADER_SIZE]);
+			return;
+		default:
+			*mLog.warn() << UTILS_STR_FUNCTION << ", drop, error: " << XBeeFrameStatus::toString(status);
+			return;
+	}
+	if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+		*mLog.debug() << UTILS_STR_FUNCTION << ", api-id: " << Utils::putByte(frame.getApiId())
+			<< ", data.size: " << frame.getDataSize();
+	}
+	if (mLog.isEnabled(Utils::LoggerLevel::TRACE)) {
+		*mLog.trace() << UTILS_STR_FUNCTION << ", data: "
+			<< Utils::putArray(frame.getData(), frame.getDataSize());
+	}
+	radio.tx.expire();
+	XBeeNetFrameDispatcher::get().dispatch(frame.getApiId(), *this, radio, buffer, frame);
 }
 
-void XBeeNet::onFrame(std::unique_ptr<XBeeBuffer> buffer) {
-	*mLog.debug() << UTILS_STR_FUNCTION << ", frame.size: "
-		<< buffer->size();
-	*mLog.trace() << UTILS_STR_FUNCTION << ", frame: "
-		<< Utils::putArray(*buffer);
-	try {
-		XBeeFrame frame(*buffer);
-		*mLog.debug() << UTILS_STR_FUNCTION << ", data.size: "
-			<< frame.getData()->getValue().size();
-		*mLog.trace() << UTILS_STR_FUNCTION << ", data: "
-			<< Utils::putArray(frame.getData()->getValue());
-		{
-			std::unique_ptr<XBeeBuffer> data(new XBeeBuffer(frame.getData()->getValue()));
-			std::unique_ptr<Networking::DataUnit> unit(new Networking::DataUnitXBee(
-					std::move(data),
-					std::unique_ptr<Networking::Address>
-						(new Networking::AddressXBeeNet(frame.getAddr64Src()->getValue())),
-					std::unique_ptr<Networking::Address>()
-			));
-			Application::get().getRouter().process(std::move(unit));
+void XBeeNet::onRxRsp(XBeeNetRadio& radio, std::unique_ptr<XBeeBuffer> buffer, const XBeeFrameView& frame) {
+	const XBeeFrameAddr64::type addr =
+			frame.get<XBeeFrameSchema::ZbRxRsp, XBeeFrameSchema::Addr64>();
+	radio.addrCache.set(addr, frame.get<XBeeFrameSchema::ZbRxRsp, XBeeFrameSchema::Addr16>());
+	XBeeNetRadio*& route = mCtx->routes[addr];
+	if (route != &radio) {
+		*mLog.info() << "Device " << Networking::AddressXbeeValT(addr) << " is reachable via " << radio.port->get();
+		route = &radio;
+		// the device connections are paused with the port
+		Application::get().getTcpNet().route(getAddress(addr), radio.port);
+	}
+	const XBeeBuffer::size_type dataOffset = frame.getDataOffset();
+	// cut the checksum off => the frame buffer is the payload after the header
+	buffer->resize(dataOffset + frame.getDataSize());
+	std::unique_ptr<Networking::DataUnit> unit(new Networking::DataUnitXBee(
+			std::move(buffer),
+			getAddress(addr),
+			NULL,
+			dataOffset
+	));
+	unit->setTime(radio.rxTime);
+	Application::get().getRouter().process(std::move(unit));
+}
+
+void XBeeNet::onTxStatus(XBeeNetRadio& radio, const XBeeFrameView& frame) {
+	const XBeeFrameDeliveryStatus::type status =
+			frame.get<XBeeFrameSchema::ZbTxStatus, XBeeFrameSchema::DeliveryStatus>();
+	if (status != XBeeFrameDeliveryStatus::SUCCESS) {
+		*mLog.warn() << UTILS_STR_FUNCTION << ", delivery failed, status: " << Utils::putByte(status);
+	}
+	radio.tx.onStatus(
+			frame.get<XBeeFrameSchema::ZbTxStatus, XBeeFrameSchema::FrameId>(),
+			frame.get<XBeeFrameSchema::ZbTxStatus, XBeeFrameSchema::Addr16>(),
+			status);
+}
+
+void XBeeNet::onModemStatus(XBeeNetRadio& radio, const XBeeFrameView& frame) {
+	const uint8_t status = frame.get<XBeeFrameSchema::ModemStatusRsp, XBeeFrameSchema::ModemStatus>();
+	*mLog.info() << "Modem status: " << Utils::putByte(status);
+	if (status == XBeeFrameModemStatus::HW_RESET || status == XBeeFrameModemStatus::WDT_RESET) {
+		// no TX Status for frames in flight
+		radio.tx.onReset();
+		resetMtu(radio);
+		queryMtu(radio);
+	}
+}
+
+void XBeeNet::onAtCmdRsp(XBeeNetRadio& radio, const XBeeFrameView& frame) {
+	if (frame.get<XBeeFrameSchema::AtCmdRsp, XBeeFrameSchema::FrameId>() != XBEE_NET_AT_FRAME_ID) {
+		*mLog.debug() << UTILS_STR_FUNCTION << ", skip, frame-id: "
+			<< Utils::putByte(frame.get<XBeeFrameSchema::AtCmdRsp, XBeeFrameSchema::FrameId>());
+		return;
+	}
+	const XBeeFrameAtCommand::type command = frame.get<XBeeFrameSchema::AtCmdRsp, XBeeFrameSchema::AtCommand>();
+	if (command == XBeeFrameAtCommand::BD) {
+		onBaud(radio, frame.get<XBeeFrameSchema::AtCmdRsp, XBeeFrameSchema::AtStatus>(),
+				frame.getData(), frame.getDataSize());
+	} else if (command == XBeeFrameAtCommand::NP) {
+		const XBeeFrameAtStatus::type status = frame.get<XBeeFrameSchema::AtCmdRsp, XBeeFrameSchema::AtStatus>();
+		if (status != XBeeFrameAtStatus::OK || frame.getDataSize() < 2) {
+			*mLog.warn() << UTILS_STR_FUNCTION << ", NP failed, status: " << Utils::putByte(status);
+			return;
+		}
+		const std::size_t mtu = (static_cast<std::size_t>(frame.getData()[0]) << 8) | frame.getData()[1];
+		if (mtu && !radio.isMtuKnown) {
+			radio.mtu = mtu;
+			radio.isMtuKnown = true;
+			*mLog.info() << "MTU: " << mtu << ", port: " << radio.port->get();
 		}
-	} catch (Utils::Error& e) {
-		*mLog.error() << UTILS_STR_FUNCTION << ", error: " << e.what();
 	}
 }
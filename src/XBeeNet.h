@@ -15,9 +15,11 @@
 #define XBEE_NET_H_
 
 /* Internal Includes */
+#include "XBeeFrame.h"
 #include "Logger.h"
 /* External Includes */
 #include "NetworkingDefs.h"
+#include "NetworkingAddress.h"
 /* System Includes */
 #include <stdint.h>
 #include <vector>
@@ -26,6 +28,8 @@
 /* Forward declaration */
 namespace Networking {class Address;}
 struct XBeeNetContext;
+struct XBeeNetRadio;
+template<typename> struct XBeeNetFrameHandler;
 
 /**
  * XBee (ZigBee) network
@@ -55,9 +59,12 @@ public:
 	/**
 	 * Processes the buffer received from XBee network
 	 *
-	 * @param buffer XBee network buffer chunk in API 2 mode
+	 * @param from source address
+	 * @param buffer XBee network buffer chunk in configured API mode
+	 * @param time reception time of the chunk
 	 */
-	void from(std::unique_ptr< std::vector<uint8_t> > buffer) throw ();
+	void from(const Networking::Address* from, std::unique_ptr< std::vector<uint8_t> > buffer,
+			Networking::Time time) throw ();
 
 	/**
 	 * Sends data to XBee network
@@ -68,6 +75,15 @@ public:
 	 */
 	void to(const Networking::Address* from, const Networking::Address* to,
 			std::unique_ptr<Networking::Buffer> buffer) throw ();
+
+	/**
+	 * Notifies about the opened serial port.
+	 * Starts the baud rate negotiation if enabled.
+	 *
+	 * @param port serial port address
+	 * @param baud current baud rate of the port
+	 */
+	void opened(const Networking::Address* port, uint32_t baud) throw ();
 private:
 	// Objects
 	Utils::Logger				mLog;
@@ -78,10 +94,32 @@ private:
 	XBeeNet &operator=(const XBeeNet&);
 
 	// Methods
-	void onFrom(std::unique_ptr< std::vector<uint8_t> > buffer);
-	void onTo(std::unique_ptr<Networking::Address>, std::unique_ptr<Networking::Address>,
+	void onFrom(const Networking::Address&, std::unique_ptr< std::vector<uint8_t> > buffer,
+			Networking::Time);
+	void onTo(const Networking::Address&, const Networking::Address&,
 			std::unique_ptr<Networking::Buffer>);
-	void onFrame(std::unique_ptr<std::vector<uint8_t> >);
+	void onSend(XBeeNetRadio&, XBeeFrameId::type, XBeeFrameAddr64::type, const Networking::Buffer&);
+	void onFlush(XBeeFrameAddr64::type);
+	void onOpened(const Networking::AddressSerialValT&, uint32_t);
+	void onBaud(XBeeNetRadio&, XBeeFrameAtStatus::type, const uint8_t*, std::size_t);
+	void onBaudTimeout(const Networking::AddressSerialValT&, uint32_t);
+	void sendBaud(XBeeNetRadio&, bool isSet);
+	void verifyBaud(XBeeNetRadio&);
+	void setBaud(XBeeNetRadio&, uint32_t);
+	XBeeNetRadio& getRadio(const Networking::AddressSerialValT&);
+	XBeeNetRadio* getRoute(XBeeFrameAddr64::type);
+	const Networking::AddressXBeeNet* getAddress(XBeeFrameAddr64::type);
+	std::size_t getMtu(const XBeeNetRadio&) const;
+	void resetMtu(XBeeNetRadio&);
+	void queryMtu(XBeeNetRadio&);
+	void write(const XBeeNetRadio&, std::unique_ptr<std::vector<uint8_t> >, XBeeFrameAddr64::type);
+	void onFrame(XBeeNetRadio&, std::unique_ptr<std::vector<uint8_t> >);
+	void onRxRsp(XBeeNetRadio&, std::unique_ptr<std::vector<uint8_t> >, const XBeeFrameView&);
+	void onTxStatus(XBeeNetRadio&, const XBeeFrameView&);
+	void onModemStatus(XBeeNetRadio&, const XBeeFrameView&);
+	void onAtCmdRsp(XBeeNetRadio&, const XBeeFrameView&);
+
+	template<typename> friend struct XBeeNetFrameHandler;
 };
 
 #endif /* XBEE_NET_H_ */
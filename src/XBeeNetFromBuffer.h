@@ -0,0 +1,284 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: XBee network. Reassembler of the received frames.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef XBEE_NET_FROM_BUFFER_H_
+#define XBEE_NET_FROM_BUFFER_H_
+
+/* Internal Includes */
+#include "XBeeFrame.h"
+#include "XBeeFrameSchema.h"
+/* External Includes */
+#include "Error.h"
+#include "Logger.h"
+/* System Includes */
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+
+
+#define API_START_DELIM						((uint8_t) XBeeFrameDelimiter::VALUE)
+#define API_ESCAPE							((uint8_t) XBeeFrameEscape::ESCAPE)
+#define API_XON								((uint8_t) XBeeFrameEscape::XON)
+#define API_XOFF							((uint8_t) XBeeFrameEscape::XOFF)
+#define DO_API_ESCPE(x)						((x)^0x20)
+#define XBEE_NET_FROM_BUFFER_DROP_LOG_MS	1000	// drops are summarized once per period
+
+/**
+ * Splits the serial byte stream to frames.
+ * Escapes are removed in API mode 2; broken frames are dropped and the
+ * stream is resynchronized on the next start delimiter.
+ */
+class XBeeNetFromBuffer {
+public:
+	typedef std::function<void(std::unique_ptr<XBeeBuffer>)> onFrame;
+
+	XBeeNetFromBuffer(const std::string& source, XBeeFrameApiMode::Type mode, onFrame cbk):
+		mLog(__FUNCTION__),
+		mSource(source),
+		mIsEscaped(mode == XBeeFrameApiMode::ESCAPED),
+		mOnFrameCbk(cbk),
+		mBuffer(new XBeeBuffer),
+		mIsEscapeSequence(false),
+		mFrameLength(0),
+		mDropQty(0),
+		mDropQtyLogged(0)
+	{
+	}
+
+	/**
+	 * Copies bytes with Escapes removing (API mode 2) or as is (API mode 1).
+	 * Runs of plain bytes are copied in blocks; after an error the stream
+	 * is skipped till the next start delimiter.
+	 *
+	 * @param buffer XBee network buffer
+	 */
+	void push(const XBeeBuffer& buffer) {
+		const uint8_t* p = buffer.data();
+		const uint8_t* end = p + buffer.size();
+		while (p < end) {
+			// wait the start of the frame
+			if (mBuffer->empty()) {
+				p = static_cast<const uint8_t*>(std::memchr(p, API_START_DELIM, end - p));
+				if (!p) {
+					break;
+				}
+				// the length is unknown yet => the biggest frame instead of growing the buffer
+				mBuffer->reserve(XBEE_FRAME_HEADER_SIZE + XBEE_FRAME_LENGTH_MAX + XBEE_FRAME_CHECKSUM_SIZE);
+				mBuffer->push_back(*(p++));
+				continue;
+			}
+			// process Escape sequence
+			if (mIsEscapeSequence) {
+				const uint8_t b = *(p++);
+				switch (b) {
+					case DO_API_ESCPE(API_START_DELIM):
+					case DO_API_ESCPE(API_ESCAPE):
+					case DO_API_ESCPE(API_XON):
+					case DO_API_ESCPE(API_XOFF):
+						mIsEscapeSequence = false;
+						mBuffer->push_back(DO_API_ESCPE(b));
+						break;
+					default:
+						drop("bad Escape");
+						if (b == API_START_DELIM) {
+							// the frame is cut => the delimiter starts the next one
+							mBuffer->push_back(API_START_DELIM);
+						}
+						continue;
+				}
+			} else if (!mIsEscaped) {
+				// no control bytes inside the frame => copy till the end of the frame
+				const uint8_t* limit = p + std::min<std::size_t>(end - p, getMissingSize());
+				mBuffer->insert(mBuffer->end(), p, limit);
+				p = limit;
+			} else {
+				// copy plain bytes till the next control byte or the end of the frame
+				const uint8_t* limit = p + std::min<std::size_t>(end - p, getMissingSize());
+				const uint8_t* control = XBeeFrameEscape::findControl(p, limit);
+				mBuffer->insert(mBuffer->end(), p, control);
+				p = control;
+				if (control != limit) {
+					p++;
+					if (*control == API_ESCAPE) {
+						mIsEscapeSequence = true;
+					} else {
+						drop("unexpected start of next frame");
+						mBuffer->push_back(API_START_DELIM);
+					}
+					continue;
+				}
+			}
+			// get length; length is 16-bit [1:2] bytes
+			if (!mFrameLength && mBuffer->size() >= XBEE_FRAME_HEADER_SIZE) {
+				mFrameLength = XBeeFrameSchema::Length::decode(mBuffer->data() + 1);
+				if (!mFrameLength || mFrameLength > XBEE_FRAME_LENGTH_MAX) {
+					drop("wrong frame-length");
+					continue;
+				}
+			}
+			// check length
+			if (mFrameLength && mBuffer->size() == getFrameSize()) {
+				// frame is received
+				pop();
+			}
+		}
+		if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+			*mLog.debug() << UTILS_STR_FUNCTION << ", new-frame.current-size: "<< mBuffer->size();
+		}
+	}
+
+private:
+	// Objects
+	Utils::Logger								mLog;
+	const std::string							mSource;
+	const bool									mIsEscaped;
+	onFrame										mOnFrameCbk;
+	std::unique_ptr<XBeeBuffer>					mBuffer;
+	bool										mIsEscapeSequence;
+	uint16_t									mFrameLength;
+	uint32_t									mDropQty;
+	uint32_t									mDropQtyLogged;
+	std::chrono::steady_clock::time_point		mDropLogTime;
+
+	/**
+	 * Notifies about new received frame and starts assembling of a new one.
+	 * Frames with wrong checksum are dropped.
+	 */
+	void pop() {
+		if (mBuffer->size() < XBEE_FRAME_HEADER_SIZE + XBEE_FRAME_CHECKSUM_SIZE
+			|| !XBeeFrameChecksum::isValid(mBuffer->data() + XBEE_FRAME_HEADER_SIZE,
+					mBuffer->size() - XBEE_FRAME_HEADER_SIZE))
+		{
+			if (mIsEscaped) {
+				drop("bad checksum");
+				return;
+			}
+			// API mode 1: the frame could start inside the dropped one
+			countDrop("bad checksum");
+			resync(1);
+			return;
+		}
+		mOnFrameCbk(std::move(mBuffer));
+		reset();
+	}
+
+	/**
+	 * API mode 1: resynchronizes on the next start delimiter inside the buffer.
+	 * The buffer is shifted in place; the complete frames found inside are notified
+	 * and the incomplete one is left for the next bytes.
+	 *
+	 * @param from index to search the start delimiter from
+	 */
+	void resync(std::size_t from) {
+		for (;;) {
+			mFrameLength = 0;
+			const uint8_t* next = mBuffer->size() > from ? static_cast<const uint8_t*>(
+					std::memchr(mBuffer->data() + from, API_START_DELIM, mBuffer->size() - from)) : NULL;
+			if (!next) {
+				reset();
+				return;
+			}
+			mBuffer->erase(mBuffer->begin(), mBuffer->begin() + (next - mBuffer->data()));
+			from = 1;
+			if (mBuffer->size() < XBEE_FRAME_HEADER_SIZE) {
+				return;
+			}
+			mFrameLength = XBeeFrameSchema::Length::decode(mBuffer->data() + 1);
+			if (!mFrameLength || mFrameLength > XBEE_FRAME_LENGTH_MAX) {
+				countDrop("wrong frame-length");
+				continue;
+			}
+			const std::size_t size = getFrameSize();
+			if (mBuffer->size() < size) {
+				return;
+			}
+			if (!XBeeFrameChecksum::isValid(mBuffer->data() + XBEE_FRAME_HEADER_SIZE, size - XBEE_FRAME_HEADER_SIZE)) {
+				countDrop("bad checksum");
+				continue;
+			}
+			// the whole frame is inside => the rest of the bytes goes to the next buffer
+			std::unique_ptr<XBeeBuffer> frame(std::move(mBuffer));
+			reset();
+			mBuffer->reserve(XBEE_FRAME_HEADER_SIZE + XBEE_FRAME_LENGTH_MAX + XBEE_FRAME_CHECKSUM_SIZE);
+			mBuffer->assign(frame->begin() + size, frame->end());
+			frame->resize(size);
+			mOnFrameCbk(std::move(frame));
+			from = 0;
+		}
+	}
+
+	/**
+	 * Drops the incomplete or broken frame
+	 */
+	void drop(const char* reason) {
+		countDrop(reason);
+		reset();
+	}
+
+	/**
+	 * Counts the dropped frame.
+	 * Noise could break every frame => the drops are logged as a summary once per period.
+	 */
+	void countDrop(const char* reason) {
+		mDropQty++;
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (mDropQtyLogged
+			&& now - mDropLogTime < std::chrono::milliseconds(XBEE_NET_FROM_BUFFER_DROP_LOG_MS))
+		{
+			return;
+		}
+		*mLog.warn() << UTILS_STR_FUNCTION << ", " << reason << " => drop, source: " << mSource
+			<< ", drops: " << mDropQty << ", since last report: " << mDropQty - mDropQtyLogged;
+		mDropLogTime = now;
+		mDropQtyLogged = mDropQty;
+	}
+
+	/**
+	 * Resets current context.
+	 * The buffer is reused if it still belongs to the context.
+	 */
+	void reset() {
+		if (mBuffer) {
+			mBuffer->clear();
+		} else {
+			mBuffer.reset(new XBeeBuffer);
+		}
+		mIsEscapeSequence = false;
+		mFrameLength = 0;
+	}
+
+	uint32_t getFrameSize() {
+		uint32_t res = 0;
+		if (mFrameLength) {
+			res =	1					// API_START_DELIM
+					+ 2					// 16-bit length
+					+ mFrameLength		// Payload
+					+ 1;				// Checksum
+		}
+		return res;
+	}
+
+	/**
+	 * Number of bytes to complete the header or the frame
+	 */
+	std::size_t getMissingSize() {
+		const std::size_t expected = mFrameLength ? getFrameSize() : XBEE_FRAME_HEADER_SIZE;
+		return expected - mBuffer->size();
+	}
+};
+
+#endif /* XBEE_NET_FROM_BUFFER_H_ */
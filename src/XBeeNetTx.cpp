@@ -0,0 +1,254 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: XBee network. Transmit flow control.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+/* Internal Includes */
+#include "XBeeNetTx.h"
+/* External Includes */
+#include "NetworkingAddress.h"
+/* System Includes */
+#include <assert.h>
+#include <algorithm>
+
+
+///////////////////// XBeeNetTx /////////////////////
+XBeeNetTx::XBeeNetTx(SendCbk send, StatusCbk status, BlockCbk block, ResetCbk reset)
+:
+	mLog(__FUNCTION__),
+	mSendCbk(send),
+	mStatusCbk(status),
+	mBlockCbk(block),
+	mResetCbk(reset),
+	mConfig({2, 0, 32, 30000}),
+	mFrameId(XBeeFrameId::NO_RSP),
+	mInFlight(0),
+	mSeq(0),
+	mIsStarving(false)
+{
+	for (Slot& i: mSlots) {
+		i.used = false;
+		i.seq = 0;
+		i.addr64 = 0;
+		i.attempt = 0;
+	}
+}
+
+void XBeeNetTx::send(XBeeFrameAddr64::type addr64, std::unique_ptr<Networking::Buffer> data,
+		std::size_t mergeLimit)
+{
+	assert(data.get());
+	expire();
+	Device& device = mDevices[addr64];
+	if (mergeLimit && !device.queue.empty() && device.queue.back()->size() + data->size() <= mergeLimit) {
+		// the window is full => fewer frames is better
+		device.queue.back()->insert(device.queue.back()->end(), data->begin(), data->end());
+		if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+			*mLog.debug() << UTILS_STR_FUNCTION << ", merged, queue.size: " << device.queue.size();
+		}
+		return;
+	}
+	if (device.queue.size() >= mConfig.queueSize) {
+		// the stream has a gap anyway => drop all and restart the session
+		device.drops++;
+		resetSession(addr64, device, "queue is full");
+		if (mIsStarving) {
+			pumpAll();
+		}
+		return;
+	}
+	device.queue.push_back(std::move(data));
+	pump(addr64, device);
+	updateBlocked(addr64, device);
+	if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+		*mLog.debug() << UTILS_STR_FUNCTION << ", queue.size: " << device.queue.size()
+			<< ", in-flight: " << device.inFlight << ", total-in-flight: " << mInFlight;
+	}
+}
+
+void XBeeNetTx::onStatus(XBeeFrameId::type frameId, XBeeFrameAddr16::type addr16,
+		XBeeFrameDeliveryStatus::type status)
+{
+	Slot& slot = mSlots[frameId];
+	if (!slot.used) {
+		if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+			*mLog.debug() << UTILS_STR_FUNCTION << ", unknown frame-id: " << Utils::putByte(frameId);
+		}
+		expire();
+		return;
+	}
+	mStatusCbk(slot.addr64, addr16, status);
+	if (status == XBeeFrameDeliveryStatus::SUCCESS) {
+		release(frameId, false);
+	} else if (slot.attempt < mConfig.retries) {
+		Device& device = mDevices[slot.addr64];
+		slot.attempt++;
+		device.retries++;
+		*mLog.warn() << UTILS_STR_FUNCTION << ", re-send, status: " << Utils::putByte(status)
+			<< ", attempt: " << slot.attempt << ", retries: " << device.retries;
+		transmit(frameId);
+	} else {
+		release(frameId, true);
+	}
+	expire();
+}
+
+void XBeeNetTx::onReset() {
+	*mLog.warn() << UTILS_STR_FUNCTION << ", forget frames in flight: " << mInFlight;
+	// the delivery of every frame in flight is unknown => every such stream has a gap
+	for (Slot& i: mSlots) {
+		if (i.used) {
+			const XBeeFrameAddr64::type addr64 = i.addr64;
+			Device& device = mDevices[addr64];
+			device.failures++;
+			resetSession(addr64, device, "module reset");
+		}
+	}
+	mOrder.clear();
+	pumpAll();
+}
+
+void XBeeNetTx::expire() {
+	if (!mConfig.timeoutMs) {
+		return;
+	}
+	const Clock::time_point now = Clock::now();
+	while (!mOrder.empty()) {
+		const XBeeFrameId::type frameId = mOrder.front().first;
+		const Slot& slot = mSlots[frameId];
+		if (!slot.used || slot.seq != mOrder.front().second) {
+			// released or re-sent
+			mOrder.pop_front();
+			continue;
+		}
+		if (now - slot.time < std::chrono::milliseconds(mConfig.timeoutMs)) {
+			break;
+		}
+		mOrder.pop_front();
+		*mLog.warn() << UTILS_STR_FUNCTION << ", no TX Status, frame-id: " << Utils::putByte(frameId);
+		release(frameId, true);
+	}
+}
+
+///////////////////// XBeeNetTx::Internal /////////////////////
+void XBeeNetTx::pump(XBeeFrameAddr64::type addr64, Device& device) {
+	while (!device.queue.empty() && device.inFlight < mConfig.window) {
+		XBeeFrameId::type frameId;
+		if (!allocate(frameId)) {
+			if (mLog.isEnabled(Utils::LoggerLevel::DEBUG)) {
+				*mLog.debug() << UTILS_STR_FUNCTION << ", no free frame-id";
+			}
+			mIsStarving = true;
+			return;
+		}
+		Slot& slot = mSlots[frameId];
+		slot.used = true;
+		slot.addr64 = addr64;
+		slot.attempt = 0;
+		slot.data = std::move(device.queue.front());
+		device.queue.pop_front();
+		device.inFlight++;
+		device.sent++;
+		mInFlight++;
+		transmit(frameId);
+	}
+	updateBlocked(addr64, device);
+}
+
+void XBeeNetTx::updateBlocked(XBeeFrameAddr64::type addr64, Device& device) {
+	const std::size_t high = std::max<std::size_t>(mConfig.queueSize / 2, 1);
+	const std::size_t low = mConfig.queueSize / 4;
+	if (!device.isBlocked && device.queue.size() >= high) {
+		device.isBlocked = true;
+		*mLog.debug() << UTILS_STR_FUNCTION << ", blocked, addr: " << Networking::AddressXbeeValT(addr64)
+			<< ", queue.size: " << device.queue.size();
+		mBlockCbk(addr64, true);
+	} else if (device.isBlocked && device.queue.size() <= low) {
+		device.isBlocked = false;
+		*mLog.debug() << UTILS_STR_FUNCTION << ", unblocked, addr: " << Networking::AddressXbeeValT(addr64)
+			<< ", queue.size: " << device.queue.size();
+		mBlockCbk(addr64, false);
+	}
+}
+
+void XBeeNetTx::pumpAll() {
+	mIsStarving = false;
+	for (auto& i: mDevices) {
+		pump(i.first, i.second);
+		if (mIsStarving) {
+			return;
+		}
+	}
+}
+
+bool XBeeNetTx::allocate(XBeeFrameId::type& frameId) {
+	for (int i = 0; i < 256; i++) {
+		if (++mFrameId == XBeeFrameId::NO_RSP) {
+			continue;
+		}
+		if (!mSlots[mFrameId].used) {
+			frameId = mFrameId;
+			return true;
+		}
+	}
+	return false;
+}
+
+void XBeeNetTx::transmit(XBeeFrameId::type frameId) {
+	Slot& slot = mSlots[frameId];
+	slot.seq = ++mSeq;
+	slot.time = Clock::now();
+	mOrder.push_back(std::make_pair(frameId, slot.seq));
+	mSendCbk(frameId, slot.addr64, *slot.data);
+}
+
+void XBeeNetTx::release(XBeeFrameId::type frameId, bool isFailed) {
+	Slot& slot = mSlots[frameId];
+	const XBeeFrameAddr64::type addr64 = slot.addr64;
+	Device& device = mDevices[addr64];
+	slot.used = false;
+	slot.data.reset();
+	device.inFlight--;
+	mInFlight--;
+	if (isFailed) {
+		device.failures++;
+		*mLog.warn() << UTILS_STR_FUNCTION << ", delivery failed, addr: " << Networking::AddressXbeeValT(addr64)
+			<< ", frame-id: " << Utils::putByte(frameId);
+		// the next slices must not be delivered after the gap
+		resetSession(addr64, device, "delivery failed");
+	}
+	if (mIsStarving) {
+		pumpAll();
+	} else {
+		pump(addr64, device);
+	}
+}
+
+void XBeeNetTx::resetSession(XBeeFrameAddr64::type addr64, Device& device, const char* reason) {
+	device.drops += device.queue.size();
+	device.queue.clear();
+	for (Slot& i: mSlots) {
+		if (i.used && i.addr64 == addr64) {
+			// a late TX Status is ignored as unknown
+			i.used = false;
+			i.data.reset();
+			device.inFlight--;
+			device.drops++;
+			mInFlight--;
+		}
+	}
+	*mLog.warn() << UTILS_STR_FUNCTION << ", " << reason << " => reset session, addr: "
+		<< Networking::AddressXbeeValT(addr64)
+		<< ", sent: " << device.sent << ", retries: " << device.retries
+		<< ", failures: " << device.failures << ", drops: " << device.drops;
+	updateBlocked(addr64, device);
+	mResetCbk(addr64);
+}
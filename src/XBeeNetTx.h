@@ -0,0 +1,174 @@
+/*
+ *******************************************************************************
+ *
+ * Purpose: XBee network. Transmit flow control.
+ *
+ *******************************************************************************
+ * Copyright Monstrenyatko 2014.
+ *
+ * Distributed under the MIT License.
+ * (See accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+ *******************************************************************************
+ */
+
+#ifndef XBEE_NET_TX_H_
+#define XBEE_NET_TX_H_
+
+/* Internal Includes */
+#include "XBeeFrame.h"
+#include "Logger.h"
+/* External Includes */
+#include "NetworkingDefs.h"
+/* System Includes */
+#include <stdint.h>
+#include <memory>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <chrono>
+
+
+/**
+ * Transmit flow control of the XBee network.
+ *
+ * Every frame is sent with own Frame Id and holds a slot of the destination
+ * window till the TX Status is received. Frames are queued when the window
+ * is full or no Frame Id is available and released as the TX Status frames
+ * arrive. Failed frames are re-sent up to the configured number of retries.
+ * The TX Status could be lost (e.g. bad checksum) => the slot is released
+ * by the time-out.
+ * The destination is reported as blocked when half of its queue is used and
+ * as unblocked when the queue drains to a quarter => the source could stop
+ * producing before the queue is full.
+ * A frame is a slice of the destination byte stream => no frame is dropped alone.
+ * The full queue, a frame failed after all retries, a lost TX Status and the
+ * module reset drop the queued and in flight frames of the destination and
+ * reset its session.
+ */
+class XBeeNetTx {
+public:
+	/**
+	 * Sends the frame to XBee network
+	 */
+	typedef std::function<void(XBeeFrameId::type, XBeeFrameAddr64::type,
+			const Networking::Buffer&)> SendCbk;
+
+	/**
+	 * Notifies about the delivery status; called before any re-sending
+	 */
+	typedef std::function<void(XBeeFrameAddr64::type, XBeeFrameAddr16::type,
+			XBeeFrameDeliveryStatus::type)> StatusCbk;
+
+	/**
+	 * Notifies about the destination queue blocking/unblocking
+	 */
+	typedef std::function<void(XBeeFrameAddr64::type, bool)> BlockCbk;
+
+	/**
+	 * Requests the destination session reset; the queued data is dropped
+	 */
+	typedef std::function<void(XBeeFrameAddr64::type)> ResetCbk;
+
+	struct Config {
+		uint32_t									window;		// frames in flight per destination
+		uint32_t									retries;	// re-sending attempts of the failed frame
+		uint32_t									queueSize;	// queued frames per destination
+		uint32_t									timeoutMs;	// TX Status waiting time-out
+	};
+
+	/**
+	 * Constructor
+	 */
+	XBeeNetTx(SendCbk send, StatusCbk status, BlockCbk block, ResetCbk reset);
+
+	/**
+	 * Sets configuration
+	 */
+	void configure(const Config& config) { mConfig = config; }
+
+	/**
+	 * Sends or queues the data
+	 *
+	 * @param addr64 destination address
+	 * @param data data to be sent
+	 * @param mergeLimit the data is appended to the last queued frame of the destination
+	 *                   if the result fits the limit; 0 disables merging
+	 */
+	void send(XBeeFrameAddr64::type addr64, std::unique_ptr<Networking::Buffer> data,
+			std::size_t mergeLimit = 0);
+
+	/**
+	 * Processes the TX Status
+	 */
+	void onStatus(XBeeFrameId::type frameId, XBeeFrameAddr16::type addr16,
+			XBeeFrameDeliveryStatus::type status);
+
+	/**
+	 * Forgets all frames in flight and resets the sessions of their
+	 * destinations; the module is restarted
+	 */
+	void onReset();
+
+	/**
+	 * Resets the sessions of the destinations of frames without TX Status
+	 * during the time-out
+	 */
+	void expire();
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Slot {
+		bool										used;
+		uint32_t									seq;
+		XBeeFrameAddr64::type						addr64;
+		uint32_t									attempt;
+		Clock::time_point							time;
+		std::unique_ptr<Networking::Buffer>			data;
+	};
+
+	struct Device {
+		std::deque<std::unique_ptr<Networking::Buffer> >	queue;
+		uint32_t									inFlight;
+		bool										isBlocked;
+		// statistics
+		uint32_t									sent;
+		uint32_t									retries;
+		uint32_t									failures;
+		uint32_t									drops;
+
+		Device(): inFlight(0), isBlocked(false), sent(0), retries(0), failures(0), drops(0) {}
+	};
+
+	// Objects
+	Utils::Logger									mLog;
+	SendCbk											mSendCbk;
+	StatusCbk										mStatusCbk;
+	BlockCbk										mBlockCbk;
+	ResetCbk										mResetCbk;
+	Config											mConfig;
+	std::unordered_map<XBeeFrameAddr64::type, Device>	mDevices;
+	// indexed by Frame Id
+	Slot											mSlots[256];
+	XBeeFrameId::type								mFrameId;
+	uint32_t										mInFlight;
+	uint32_t										mSeq;
+	// Frame Id and sequence in order of sending
+	std::deque<std::pair<XBeeFrameId::type, uint32_t> >	mOrder;
+	// some destination waits a free Frame Id
+	bool											mIsStarving;
+
+	// Do not copy
+	XBeeNetTx(const XBeeNetTx&);
+	XBeeNetTx &operator=(const XBeeNetTx&);
+
+	// Methods
+	void pump(XBeeFrameAddr64::type addr64, Device& device);
+	void pumpAll();
+	void updateBlocked(XBeeFrameAddr64::type addr64, Device& device);
+	bool allocate(XBeeFrameId::type& frameId);
+	void transmit(XBeeFrameId::type frameId);
+	void release(XBeeFrameId::type frameId, bool isFailed);
+	void resetSession(XBeeFrameAddr64::type addr64, Device& device, const char* reason);
+};
+
+#endif /* XBEE_NET_TX_H_ */